@@ -40,7 +40,7 @@ class IITerator2{            // Pure abstract based class iow: c++ interface
         
     // Any polymorphic base class must have a virtual destructor.
     // Compiler generates optimal distructor
-        virtual ~IITerator() = default;
+        virtual ~IITerator2() = default;
 };
 
 // Basic Iterator using the defination above Plug - n - play
@@ -50,6 +50,15 @@ class IITerator2{            // Pure abstract based class iow: c++ interface
 #include <queue>
 #include <string>
 #include <utility>
+#include <span>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <concepts>
+#include <iterator>
+#include <ranges>
+#include <tuple>
+#include <memory>
 
 using namespace std;
 
@@ -62,6 +71,15 @@ class IIterator{
         
         virtual bool hasNext() const=0;
         virtual T next()=0;
+        
+        // Batch version of next(): fills out with up to out.size() elements and returns how
+        // many, 0 once exhausted. Default is the element loop; containers override it with
+        // a bulk copy so a whole batch costs one virtual call.
+        virtual size_t nextBatch(span<T> out){
+            size_t n = 0;
+            while(n<out.size() && hasNext()) out[n++] = next();
+            return n;
+        }
         // virtual distuctor
         virtual ~IIterator() = default; // letting compiler handel it with the default behaviour  
     
@@ -72,15 +90,18 @@ class VectorIterator : public IIterator<T>{
     // we are extending VectorIterator with the c
     
     private:
-        vector<T> data;      // Here the data is asking for reference
-    // Iterator does NOT own data
+        span<const T> data;      // Here the data is asking for reference
+    // Iterator does NOT own data: the vector has to outlive the iterator
         size_t index = 0;
     
     public: 
     
         // Constructor
-        explicit VectorIterator(vector<T> vec) : data(std::move(vec)){}
-    // Iterator DOES own data
+        explicit VectorIterator(span<const T> vec) : data(vec){}
+        explicit VectorIterator(const vector<T>& vec) : data(vec){}
+    // A temporary would be gone before the first next(), so that's a compile error.
+    // OwningVectorIterator is the opt-in for iterators that keep their data
+        VectorIterator(vector<T>&& vec) = delete;
     
         T next() override{
             if(!hasNext()) throw out_of_range("No more elements to access");
@@ -90,19 +111,57 @@ class VectorIterator : public IIterator<T>{
         bool hasNext() const override{
             return index<data.size();
         }
+        
+        size_t nextBatch(span<T> out) override{
+            size_t n = min(out.size(), data.size()-index);
+            copy_n(data.begin()+index, n, out.begin());
+            index+=n;
+            return n;
+        }
+};
+
+// Storage built before the view that points into it (base classes go in declaration order)
+template <typename T>
+struct OwnedData{
+    T owned;
+};
+
+template <typename T>
+class OwningVectorIterator : private OwnedData<vector<T>>, public VectorIterator<T>{
+    public:
+        explicit OwningVectorIterator(vector<T> vec)
+            : OwnedData<vector<T>>{std::move(vec)}, VectorIterator<T>(span<const T>(this->owned)){}
+        OwningVectorIterator(const OwningVectorIterator&) = delete;     // the copy would view the original
 };
 
+// Views the rows like VectorIterator views its vector: they must outlive the iterator
 template <typename T>
 class ZigZagIterator: public IIterator<T>{
     private:
-        vector<vector<T>> data;
-        queue<pair<int, int>> q;                 // this will store the Index so explicitely mentioning that
+        span<const vector<T>> data;
+        // (row, col) of every row that still has elements, in visiting order. A vector with a
+        // cursor instead of a queue so nextBatch can hand out whole rounds at once
+        vector<pair<size_t, size_t>> rows;
+        size_t cur = 0;
+        
+        T step(){
+            auto& [row, col] = rows[cur];
+            T val = data[row][col++];
+            if(col==data[row].size()){
+                rows.erase(rows.begin()+cur);
+                if(cur==rows.size()) cur = 0;
+            } else if(++cur==rows.size()){
+                cur = 0;
+            }
+            return val;
+        }
     
     public:
-        ZigZagIterator(vector<vector<T>> vec): data(std::move(vec)) {
-            for(int i=0; i<data.size(); i++){
+        ZigZagIterator(vector<vector<T>>&& vec) = delete;
+        ZigZagIterator(const vector<vector<T>>& vec): data(vec) {
+            for(size_t i=0; i<data.size(); i++){
                 if(!data[i].empty()){
-                    q.push({i, 0});
+                    rows.push_back({i, 0});
                 }
             }
         }
@@ -111,31 +170,453 @@ class ZigZagIterator: public IIterator<T>{
             if(!hasNext()){
                throw out_of_range("No more elements in ZigZagIterator to visit");
             }
-            auto [row, col] = q.front();
-            q.pop();
-            
-            T val= data[row][col];
-            
-            if(col+1<data[row].size()) q.push({row, col+1});
-            
-            return val;
+            return step();
         }
     
     bool hasNext() const override{
-        return !q.empty();
+        return !rows.empty();
+    }
+    
+    size_t nextBatch(span<T> out) override{
+        size_t n = 0;
+        while(n<out.size() && !rows.empty()){
+            if(cur==0){
+                // whole rounds while no row can run out
+                size_t rounds = (out.size()-n)/rows.size();
+                for(auto& [row, col] : rows) rounds = min(rounds, data[row].size()-col-1);
+                for(size_t r=0; r<rounds; r++)
+                    for(auto& [row, col] : rows) out[n++] = data[row][col+r];
+                for(auto& [row, col] : rows) col+=rounds;
+                if(n==out.size()) break;
+            }
+            out[n++] = step();
+        }
+        return n;
     }
 };
 
+template <typename T>
+class OwningZigZagIterator : private OwnedData<vector<vector<T>>>, public ZigZagIterator<T>{
+    public:
+        explicit OwningZigZagIterator(vector<vector<T>> vec)
+            : OwnedData<vector<vector<T>>>{std::move(vec)}, ZigZagIterator<T>(this->owned){}
+        OwningZigZagIterator(const OwningZigZagIterator&) = delete;
+};
+
  /*--------------------------------------------------
 PART 3 — Interleaving Iterator
 This is multiple iterators round-robin.
 --------------------------------------------------*/
 //Patter used Queue of Iterators: each iterator adavances only when used
+// Each iterator gets a 64 element buffer filled through nextBatch, so taking an element
+// is an array read. Iterators are read up to 64 elements ahead of what was handed out.
+
+// The buffered round robin itself, also used by the static combinators in PART 4. Lanes only
+// know their source's index; the owner passes refill(source, buf) on every call, a virtual
+// nextBatch here and an inlined one there, so the helper itself has nothing virtual.
+template <typename T>
+class LaneBuffers{
+    private:
+        struct Lane{
+            size_t source;
+            vector<T> buf;
+            size_t pos = 0, len = 0;
+        };
+        vector<Lane> lanes;         // the ones with elements left, in turn order
+        size_t cur = 0;
+    
+    public:
+        template <typename Refill>
+        void add(size_t source, Refill&& refill){
+            Lane l{source, vector<T>(64)};
+            l.len = refill(source, span<T>(l.buf));
+            if(l.len>0) lanes.push_back(std::move(l));
+        }
+        
+        bool empty() const{ return lanes.empty(); }
+        
+        template <typename Refill>
+        T take(Refill&& refill){
+            Lane& l = lanes[cur];
+            T val = std::move(l.buf[l.pos++]);
+            if(l.pos==l.len){
+                l.pos = 0;
+                l.len = refill(l.source, span<T>(l.buf));
+                if(l.len==0){
+                    lanes.erase(lanes.begin()+cur);
+                    if(cur==lanes.size()) cur = 0;
+                    return val;
+                }
+            }
+            if(++cur==lanes.size()) cur = 0;
+            return val;
+        }
+        
+        template <typename Refill>
+        size_t takeBatch(span<T> out, Refill&& refill){
+            size_t n = 0;
+            while(n<out.size() && !lanes.empty()){
+                if(cur==0){
+                    // whole rounds while every lane has buffered elements to spare
+                    size_t rounds = (out.size()-n)/lanes.size();
+                    for(auto& l : lanes) rounds = min(rounds, l.len-l.pos-1);
+                    for(size_t r=0; r<rounds; r++)
+                        for(auto& l : lanes) out[n++] = std::move(l.buf[l.pos+r]);
+                    for(auto& l : lanes) l.pos+=rounds;
+                    if(n==out.size()) break;
+                }
+                out[n++] = take(refill);
+            }
+            return n;
+        }
+};
 
 template <typename T>
 class InterleavingIterator : public IIterator<T>{
     private:
-        queue<IITerator<T>*> iters;
+        vector<IIterator<T>*> sources;
+        LaneBuffers<T> lanes;
+        
+        auto refill(){
+            return [this](size_t source, span<T> buf){ return sources[source]->nextBatch(buf); };
+        }
+    
+    public:
+        // does not own the iterators, they have to outlive this one
+        InterleavingIterator(const vector<IIterator<T>*>& its) : sources(its){
+            for(size_t i=0; i<sources.size(); i++) lanes.add(i, refill());
+        }
+        
+        bool hasNext() const override{
+            return !lanes.empty();
+        }
+        
+        T next() override{
+            if(!hasNext()) throw out_of_range("No more elements in InterleavingIterator");
+            return lanes.take(refill());
+        }
+        
+        size_t nextBatch(span<T> out) override{
+            return lanes.takeBatch(out, refill());
+        }
+};
+
+// 10M ints through Interleaving(vector, zigzag), element at a time vs in batches
+void benchBatch(){
+    const int n = 10000000;
+    vector<int> big(n/2);
+    iota(big.begin(), big.end(), 0);
+    vector<vector<int>> rows(8, vector<int>(n/16, 7));
+    
+    for(bool batched : {false, true}){
+        double ms = 1e18;
+        long long sum = 0, count = 0;
+        for(int run=0; run<5; run++){     // best of 5 runs
+            VectorIterator<int> vec(big);
+            ZigZagIterator<int> zz(rows);
+            InterleavingIterator<int> mixed({&vec, &zz});
+            IIterator<int>& it = mixed;
+        
+            auto start = chrono::steady_clock::now();
+            sum = 0, count = 0;
+            if(batched){
+                int buf[1024];
+                for(size_t got; (got = it.nextBatch(buf))>0; count+=got)
+                    for(size_t i=0; i<got; i++) sum+=buf[i];
+            } else {
+                for(; it.hasNext(); count++) sum+=it.next();
+            }
+            ms = min(ms, chrono::duration<double, milli>(chrono::steady_clock::now()-start).count());
+        }
+        cout<<(batched ? "nextBatch:     " : "hasNext/next:  ")<<count<<" elements in "<<ms<<" ms (sum "<<sum<<")"<<endl;
+    }
+}
+
+/*--------------------------------------------------
+PART 4 — Static Iterators
+Same hasNext()/next() shape, but no virtual base: a pipeline is one concrete type
+so the compiler can inline it end to end. Each also exposes begin()/end() and works
+with std::ranges algorithms. StaticZigZag and StaticInterleave run on the same
+LaneBuffers as InterleavingIterator. IIteratorAdapter turns any of them into an
+IIterator<T> when runtime polymorphism is needed.
+--------------------------------------------------*/
+
+template <typename I>
+concept StaticIterator = requires(I it, const I cit, span<typename I::value_type> out){
+    typename I::value_type;
+    { cit.hasNext() } -> convertible_to<bool>;
+    { it.next() } -> convertible_to<typename I::value_type>;
+    { it.nextBatch(out) } -> convertible_to<size_t>;
+};
+
+// CRTP base giving any static iterator an input range interface (single pass, like the iterator itself)
+template <typename Derived, typename T>
+class StaticRange{
+    public:
+        class iterator{
+            private:
+                Derived* self = nullptr;
+                T current{};
+                bool done = true;
+            
+            public:
+                using value_type = T;
+                using difference_type = ptrdiff_t;
+                
+                iterator() = default;
+                explicit iterator(Derived* self) : self(self){ ++*this; }
+                
+                const T& operator*() const{ return current; }
+                iterator& operator++(){
+                    done = !self->hasNext();
+                    if(!done) current = self->next();
+                    return *this;
+                }
+                void operator++(int){ ++*this; }
+                bool operator==(default_sentinel_t) const{ return done; }
+        };
+        
+        iterator begin(){ return iterator(static_cast<Derived*>(this)); }
+        default_sentinel_t end(){ return default_sentinel; }
+};
+
+// A view, same contract as VectorIterator: the data must outlive the iterator
+template <typename T>
+class StaticVectorIterator : public StaticRange<StaticVectorIterator<T>, T>{
+    private:
+        // a pointer cursor, not an index: stores to a size_t index could alias the size_t
+        // state of an enclosing combinator and force it back to memory on every element
+        const T* pos;
+        const T* last;
+    
+    public:
+        using value_type = T;
+        
+        explicit StaticVectorIterator(span<const T> vec) : pos(vec.data()), last(vec.data()+vec.size()){}
+        explicit StaticVectorIterator(const vector<T>& vec) : StaticVectorIterator(span<const T>(vec)){}
+        StaticVectorIterator(vector<T>&& vec) = delete;
+        
+        bool hasNext() const{ return pos!=last; }
+        T next(){ return *pos++; }      // no bounds check: callers ask hasNext() first
+        size_t nextBatch(span<T> out){
+            size_t n = min<size_t>(out.size(), last-pos);
+            copy_n(pos, n, out.begin());
+            pos+=n;
+            return n;
+        }
+};
+
+template <integral T>
+class StaticRangeIterator : public StaticRange<StaticRangeIterator<T>, T>{
+    private:
+        long long current, end, step;
+    
+    public:
+        using value_type = T;
+        
+        StaticRangeIterator(T start, T end, T step) : current(start), end(end), step(step){
+            if(step==0) throw invalid_argument("Step cannot be zero");
+        }
+        
+        bool hasNext() const{ return step>0 ? current<=end : current>=end; }
+        T next(){
+            T val = current;
+            current+=step;
+            return val;
+        }
+        size_t nextBatch(span<T> out){
+            if(!hasNext()) return 0;
+            size_t n = min<long long>(out.size(), (end-current)/step + 1);
+            for(size_t i=0; i<n; i++) out[i] = current + (long long)i*step;
+            current+=(long long)n*step;
+            return n;
+        }
+};
+
+// Round robin over iterators of one type, e.g. one StaticVectorIterator per row
+template <StaticIterator It>
+class StaticZigZag : public StaticRange<StaticZigZag<It>, typename It::value_type>{
+    public:
+        using value_type = typename It::value_type;
+    
+    private:
+        vector<It> sources;
+        LaneBuffers<value_type> lanes;
+        
+        auto refill(){
+            return [this](size_t source, span<value_type> buf){ return sources[source].nextBatch(buf); };
+        }
+    
+    public:
+        explicit StaticZigZag(vector<It> its) : sources(std::move(its)){
+            for(size_t i=0; i<sources.size(); i++) lanes.add(i, refill());
+        }
+        
+        bool hasNext() const{ return !lanes.empty(); }
+        value_type next(){ return lanes.take(refill()); }      // no check: callers ask hasNext() first
+        size_t nextBatch(span<value_type> out){ return lanes.takeBatch(out, refill()); }
+};
+
+// views every row, so rows must outlive the zigzag
+template <typename T>
+StaticZigZag<StaticVectorIterator<T>> makeStaticZigZag(const vector<vector<T>>& rows){
+    vector<StaticVectorIterator<T>> lanes;
+    for(auto& row : rows) lanes.emplace_back(row);
+    return StaticZigZag<StaticVectorIterator<T>>(std::move(lanes));
+}
+
+template <typename T>
+void makeStaticZigZag(vector<vector<T>>&& rows) = delete;
+
+// Round robin over iterators of different types. Refilling a lane picks its source with a
+// fold over the tuple, which compiles down to a small switch instead of a virtual call.
+template <StaticIterator First, StaticIterator... Rest>
+    requires (same_as<typename First::value_type, typename Rest::value_type> && ...)
+class StaticInterleave : public StaticRange<StaticInterleave<First, Rest...>, typename First::value_type>{
+    public:
+        using value_type = typename First::value_type;
+    
+    private:
+        tuple<First, Rest...> its;
+        LaneBuffers<value_type> lanes;
+        
+        auto refill(){
+            return [this](size_t source, span<value_type> buf){
+                size_t n = 0;
+                [&]<size_t... I>(index_sequence<I...>){
+                    ((source==I && (n = get<I>(its).nextBatch(buf), true)) || ...);
+                }(index_sequence_for<First, Rest...>());
+                return n;
+            };
+        }
+    
+    public:
+        StaticInterleave(First first, Rest... rest) : its(std::move(first), std::move(rest)...){
+            for(size_t i=0; i<1+sizeof...(Rest); i++) lanes.add(i, refill());
+        }
+        
+        bool hasNext() const{ return !lanes.empty(); }
+        value_type next(){ return lanes.take(refill()); }      // no check: callers ask hasNext() first
+        size_t nextBatch(span<value_type> out){ return lanes.takeBatch(out, refill()); }
+};
+
+// Type erasure back into the virtual family. nextBatch stays one virtual call per batch,
+// with the wrapped pipeline inlined inside it.
+template <StaticIterator It>
+class IIteratorAdapter : public IIterator<typename It::value_type>{
+    private:
+        It it;
+    
+    public:
+        using T = typename It::value_type;
+        
+        explicit IIteratorAdapter(It it) : it(std::move(it)){}
+        
+        bool hasNext() const override{ return it.hasNext(); }
+        T next() override{
+            if(!it.hasNext()) throw out_of_range("No more elements");
+            return it.next();
+        }
+        size_t nextBatch(span<T> out) override{
+            return it.nextBatch(out);
+        }
+};
+
+template <StaticIterator It>
+unique_ptr<IIterator<typename It::value_type>> makeIIterator(It it){
+    return make_unique<IIteratorAdapter<It>>(std::move(it));
+}
+
+static_assert(ranges::input_range<StaticInterleave<StaticVectorIterator<int>, StaticRangeIterator<int>>>);
+
+// 10M ints through a vector iterator, virtual vs static, a static range bridged into an
+// InterleavingIterator next to a virtual vector, and zigzag(interleave(vector, range)) over
+// 8 lanes built from either family
+void benchStatic(){
+    const int n = 10000000;
+    vector<int> big(n);
+    iota(big.begin(), big.end(), 0);
+    
+    auto time = [](const char* label, auto&& drain){
+        double ms = 1e18;
+        long long sum = 0;
+        for(int run=0; run<5; run++){     // best of 5 runs
+            auto start = chrono::steady_clock::now();
+            sum = drain();
+            ms = min(ms, chrono::duration<double, milli>(chrono::steady_clock::now()-start).count());
+        }
+        cout<<label<<ms<<" ms (sum "<<sum<<")"<<endl;
+    };
+    // behind a pointer, as callers of the virtual family hold it, so the calls stay virtual
+    time("virtual hasNext/next:    ", [&]{
+        unique_ptr<IIterator<int>> it = make_unique<VectorIterator<int>>(big);
+        long long sum = 0;
+        while(it->hasNext()) sum+=it->next();
+        return sum;
+    });
+    time("static hasNext/next:     ", [&]{
+        StaticVectorIterator<int> it(big);
+        long long sum = 0;
+        while(it.hasNext()) sum+=it.next();
+        return sum;
+    });
+    time("static ranges::for_each: ", [&]{
+        StaticVectorIterator<int> it(big);
+        long long sum = 0;
+        ranges::for_each(it, [&](int v){ sum+=v; });
+        return sum;
+    });
+    time("interleave with adapter: ", [&]{
+        VectorIterator<int> vec(span<const int>(big).first(n/2));
+        IIteratorAdapter range(StaticRangeIterator<int>(n/2, n-1, 1));
+        InterleavingIterator<int> it({&vec, &range});
+        long long sum = 0;
+        int buf[1024];
+        for(size_t got; (got = it.nextBatch(buf))>0;)
+            for(size_t i=0; i<got; i++) sum+=buf[i];
+        return sum;
+    });
+    
+    // lane i interleaves big's i-th sixteenth with the range after the last one; the virtual
+    // family has no range iterator, so there the range is a vector holding the same values
+    const int lanes = 8, part = n/(2*lanes);
+    vector<vector<int>> ranges(lanes, vector<int>(part));
+    for(int i=0; i<lanes; i++) iota(ranges[i].begin(), ranges[i].end(), n/2 + i*part);
+    auto drain = [](auto& it, bool batched){
+        long long sum = 0;
+        if(batched){
+            int buf[1024];
+            for(size_t got; (got = it.nextBatch(buf))>0;)
+                for(size_t i=0; i<got; i++) sum+=buf[i];
+        } else {
+            while(it.hasNext()) sum+=it.next();
+        }
+        return sum;
+    };
+    for(bool batched : {false, true}){
+        time(batched ? "virtual zigzag(interleave), batched: " : "virtual zigzag(interleave):          ", [&]{
+            vector<unique_ptr<IIterator<int>>> parts;
+            vector<IIterator<int>*> mixed;
+            for(int i=0; i<lanes; i++){
+                parts.push_back(make_unique<VectorIterator<int>>(span<const int>(big).subspan(i*part, part)));
+                parts.push_back(make_unique<VectorIterator<int>>(ranges[i]));
+                parts.push_back(make_unique<InterleavingIterator<int>>(
+                    vector<IIterator<int>*>{parts[parts.size()-2].get(), parts.back().get()}));
+                mixed.push_back(parts.back().get());
+            }
+            unique_ptr<IIterator<int>> it = make_unique<InterleavingIterator<int>>(mixed);
+            return drain(*it, batched);
+        });
+        time(batched ? "static zigzag(interleave), batched:  " : "static zigzag(interleave):           ", [&]{
+            using Mixed = StaticInterleave<StaticVectorIterator<int>, StaticRangeIterator<int>>;
+            vector<Mixed> mixed;
+            for(int i=0; i<lanes; i++)
+                mixed.emplace_back(StaticVectorIterator<int>(span<const int>(big).subspan(i*part, part)),
+                                   StaticRangeIterator<int>(n/2 + i*part, n/2 + (i+1)*part - 1, 1));
+            StaticZigZag<Mixed> it(std::move(mixed));
+            return drain(it, batched);
+        });
+    }
 }
 
 int main2(){
@@ -143,7 +624,7 @@ int main2(){
     /*--------------------------------------------------
      PART 1 — Vector Traversal of a 2D List
     --------------------------------------------------*/
-    VectorIterator<int> vecIT({1, 3, 54});
+    OwningVectorIterator<int> vecIT({1, 3, 54});
     while(vecIT.hasNext()){
         cout<<"Next element in the vector is: "<< vecIT.next()<< endl;
     }
@@ -154,7 +635,7 @@ int main2(){
      PART 2 — Zigzag Traversal of a 2D List
     --------------------------------------------------*/
     {
-        ZigZagIterator<string> zzIT({
+        OwningZigZagIterator<string> zzIT({
         {"sdasf", "two"}, \
         {"kirtee"}, 
         {"fa", "dsafa", "dfasfaga", "fdafaga"}});
@@ -183,7 +664,7 @@ int main(){
     /*--------------------------------------------------
      PART 1 — Basic Iterator (Vector Iterator)
     --------------------------------------------------*/
-    VectorIterator<int> vecIT({1, 3, 54});
+    OwningVectorIterator<int> vecIT({1, 3, 54});
     while(vecIT.hasNext()){
         cout<<"Next element in the vector is: "<< vecIT.next()<< endl;
     }
@@ -203,7 +684,7 @@ int main(){
      PART 2 — Zigzag Traversal of a 2D List
     --------------------------------------------------*/
     {
-        ZigZagIterator<string> zzIT({
+        OwningZigZagIterator<string> zzIT({
         {"sdasf", "two"}, \
         {"kirtee"}, 
         {"fa", "dsafa", "dfasfaga", "fdafaga"}});
@@ -224,4 +705,46 @@ int main(){
     
     }
     
+    /*--------------------------------------------------
+     PART 3 — Interleaving Iterator
+    --------------------------------------------------*/
+    {
+        OwningVectorIterator<int> first({1, 2, 3});
+        OwningZigZagIterator<int> second({{10, 11}, {20}});
+        InterleavingIterator<int> interleaved({&first, &second});
+        while(interleaved.hasNext()){
+            cout<<interleaved.next()<<" ";
+        }
+        cout<<endl;
+    }
+    
+    /*--------------------------------------------------
+     PART 4 — Static Iterators
+    --------------------------------------------------*/
+    {
+        vector<int> first = {1, 2, 3};
+        for(int v : StaticVectorIterator<int>(first)){
+            cout<<v<<" ";
+        }
+        cout<<endl;
+        
+        // the same round robin, all static: zigzag over rows, then mixed with a range
+        vector<vector<int>> rows = {{1, 2}, {10}, {20, 21, 22}};
+        for(int v : StaticInterleave(makeStaticZigZag(rows), StaticRangeIterator<int>(100, 80, -10))){
+            cout<<v<<" ";
+        }
+        cout<<endl;
+        
+        // a static range taking turns with a virtual vector iterator
+        auto evens = makeIIterator(StaticRangeIterator<int>(100, 80, -10));
+        VectorIterator<int> firstAgain(first);
+        InterleavingIterator<int> mixed({&firstAgain, evens.get()});
+        while(mixed.hasNext()){
+            cout<<mixed.next()<<" ";
+        }
+        cout<<endl;
+    }
+    
+    benchBatch();
+    benchStatic();
 }
\ No newline at end of file
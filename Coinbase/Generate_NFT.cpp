@@ -1,4 +1,5 @@
 #include <bits/stdc++.h>
+#include <malloc.h>
 using namespace std;
 
 struct TraitValue {
@@ -9,16 +10,384 @@ struct TraitValue {
 struct Trait {
     string name;
     vector<TraitValue> values;
-    vector<double> cdf;
+    // built by the generator, so {name, values} is all a caller writes
+    vector<double> cdf = {};
+    // alias table: slot i keeps value i with probability prob[i], else gives alias[i]
+    vector<double> prob = {};
+    vector<int> alias = {};
+};
+
+// CDF maps each random number exactly as the spec does (binary search per draw).
+// Alias is O(1) per draw but maps the same random to a different value, so only
+// the distribution matches, not the exact sequence.
+enum class Sampling { CDF, Alias };
+
+// "trait=value excludes other=otherValue" or "trait=value requires other=otherValue".
+// An empty value matches every value of its trait, so {Excludes, "hat", "", "hair", "bald"}
+// reads "any hat excludes hair=bald".
+struct Constraint {
+    enum Kind { Excludes, Requires };
+    Kind kind;
+    string trait, value;
+    string other, otherValue;
+};
+
+// Trait and value names, interned once per generator and shared by every collection it makes.
+struct NFTSchema {
+    vector<string> traitNames;
+    vector<vector<string>> valueNames;
+};
+
+// Columnar NFTs: column t holds the value index of trait t for every NFT, 2 bytes a cell
+// instead of a map of strings per NFT. Maps are only built when asked for.
+class NFTCollection {
+private:
+    shared_ptr<const NFTSchema> schema;
+    vector<vector<uint16_t>> columns;
+
+public:
+    explicit NFTCollection(shared_ptr<const NFTSchema> schema)
+        : schema(move(schema)), columns(this->schema->traitNames.size()) {}
+
+    const NFTSchema &names() const { return *schema; }
+    size_t size() const { return columns.empty() ? 0 : columns[0].size(); }
+    size_t traitCount() const { return columns.size(); }
+
+    void append(const vector<int> &picks) {
+        for (size_t t = 0; t < columns.size(); t++)
+            columns[t].push_back(picks[t]);
+    }
+
+    void clear() {
+        for (auto &c : columns) c.clear();
+    }
+
+    int valueIndex(size_t i, size_t trait) const { return columns[trait][i]; }
+    const vector<uint16_t> &column(size_t trait) const { return columns[trait]; }
+
+    const string &value(size_t i, size_t trait) const {
+        return schema->valueNames[trait][columns[trait][i]];
+    }
+
+    map<string, string> at(size_t i) const {
+        map<string, string> nft;
+        for (size_t t = 0; t < columns.size(); t++)
+            nft[schema->traitNames[t]] = value(i, t);
+        return nft;
+    }
+
+    vector<map<string, string>> toMaps() const {
+        vector<map<string, string>> result;
+        result.reserve(size());
+        for (size_t i = 0; i < size(); i++)
+            result.push_back(at(i));
+        return result;
+    }
+
+    size_t bytes() const {
+        return traitCount() * size() * sizeof(uint16_t);
+    }
+};
+
+// Rarity of every NFT in a collection, from inverse trait frequencies.
+//   Sum:     sum over traits of 1 / freq(value)
+//   Product: product of 1 / freq(value), kept as its log (a sum of logs) so it can't overflow;
+//            the ranking is the same
+// Frequencies come from the collection itself (one counting pass per column) or from the
+// trait weights. Scoring then only adds up table[value] column by column, in blocks small
+// enough to stay in cache; the inner loop has no branches, so the compiler can vectorize it.
+class RarityEngine {
+public:
+    enum Mode { Sum, Product };
+
+private:
+    vector<vector<float>> table;  // per trait, per value: what that value adds to the score
+
+    static float contribution(double freq, Mode mode) {
+        if (freq <= 0) return 0;  // value never occurs, no NFT will look it up
+        return mode == Sum ? 1.0 / freq : -log(freq);
+    }
+
+public:
+    RarityEngine(const NFTCollection &nfts, Mode mode) {
+        const NFTSchema &names = nfts.names();
+        for (size_t t = 0; t < nfts.traitCount(); t++) {
+            vector<size_t> counts(names.valueNames[t].size());
+            for (uint16_t v : nfts.column(t)) counts[v]++;
+            table.emplace_back();
+            for (size_t c : counts)
+                table.back().push_back(contribution(double(c) / nfts.size(), mode));
+        }
+    }
+
+    // expected rarity from the weights, the same for any collection drawn from these traits
+    RarityEngine(const vector<Trait> &traits, Mode mode) {
+        for (auto &t : traits) {
+            double sum = 0.0;
+            for (auto &v : t.values) sum += v.weight;
+            table.emplace_back();
+            for (auto &v : t.values)
+                table.back().push_back(contribution(v.weight / sum, mode));
+        }
+    }
+
+    vector<float> score(const NFTCollection &nfts) const {
+        static constexpr size_t BLOCK = 4096;
+        size_t n = nfts.size();
+        vector<float> scores(n, 0.0f);
+        for (size_t from = 0; from < n; from += BLOCK) {
+            size_t to = min(n, from + BLOCK);
+            for (size_t t = 0; t < table.size(); t++) {
+                const uint16_t *column = nfts.column(t).data();
+                const float *values = table[t].data();
+                float *out = scores.data();
+                for (size_t i = from; i < to; i++)
+                    out[i] += values[column[i]];
+            }
+        }
+        return scores;
+    }
+
+    // (score, index) of the k rarest NFTs, rarest first
+    vector<pair<float, size_t>> topK(const NFTCollection &nfts, size_t k) const {
+        vector<float> scores = score(nfts);
+        priority_queue<pair<float, size_t>, vector<pair<float, size_t>>, greater<>> heap;
+        for (size_t i = 0; i < scores.size(); i++) {
+            if (heap.size() < k) heap.push({scores[i], i});
+            else if (k && scores[i] > heap.top().first) {
+                heap.pop();
+                heap.push({scores[i], i});
+            }
+        }
+        vector<pair<float, size_t>> result;
+        for (; !heap.empty(); heap.pop()) result.push_back(heap.top());
+        reverse(result.begin(), result.end());
+        return result;
+    }
+};
+
+// Writes collections as one JSON array of objects or as CSV with a header row. Call
+// write() once per batch and finish() at the end; nothing is kept between batches.
+class NFTWriter {
+public:
+    enum Format { JSON, CSV };
+
+private:
+    ostream &out;
+    Format format;
+    bool started = false;
+    string buffer;
+
+    void quoted(const string &s) {
+        if (format == JSON) {
+            buffer += '"';
+            for (char c : s) {
+                if (c == '"' || c == '\\') buffer += '\\';
+                if ((unsigned char)c < 0x20) {
+                    char esc[8];
+                    snprintf(esc, sizeof esc, "\\u%04x", c);
+                    buffer += esc;
+                } else {
+                    buffer += c;
+                }
+            }
+            buffer += '"';
+        } else if (s.find_first_of(",\"\r\n") == string::npos) {
+            buffer += s;
+        } else {
+            buffer += '"';
+            for (char c : s) {
+                if (c == '"') buffer += '"';
+                buffer += c;
+            }
+            buffer += '"';
+        }
+    }
+
+public:
+    NFTWriter(ostream &out, Format format) : out(out), format(format) {}
+
+    void write(const NFTCollection &batch) {
+        const NFTSchema &names = batch.names();
+        buffer.clear();
+        if (!started && format == JSON) buffer += "[";
+        if (!started && format == CSV) {
+            for (size_t t = 0; t < batch.traitCount(); t++) {
+                if (t) buffer += ',';
+                quoted(names.traitNames[t]);
+            }
+            buffer += '\n';
+        }
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (format == JSON) {
+                buffer += started || i ? ",\n{" : "\n{";
+                for (size_t t = 0; t < batch.traitCount(); t++) {
+                    if (t) buffer += ", ";
+                    quoted(names.traitNames[t]);
+                    buffer += ": ";
+                    quoted(batch.value(i, t));
+                }
+                buffer += '}';
+            } else {
+                for (size_t t = 0; t < batch.traitCount(); t++) {
+                    if (t) buffer += ',';
+                    quoted(batch.value(i, t));
+                }
+                buffer += '\n';
+            }
+        }
+        started = true;
+        out.write(buffer.data(), buffer.size());
+    }
+
+    void finish() {
+        if (format == JSON) out << (started ? "\n]\n" : "[]\n");
+        out.flush();
+    }
+};
+
+// xoshiro256** seeded through splitmix64. jump() advances 2^128 draws, so stream k
+// (k jumps from the seed) never overlaps streams 0..k-1 in practice. longJump() advances
+// 2^192, far enough to split a stream again without running into the streams after it.
+class Xoshiro256 {
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    void advance(const uint64_t (&poly)[4]) {
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (uint64_t word : poly)
+            for (int b = 0; b < 64; b++) {
+                if (word & (1ULL << b))
+                    for (int i = 0; i < 4; i++) t[i] ^= s[i];
+                next();
+            }
+        copy(t, t + 4, s);
+    }
+
+public:
+    explicit Xoshiro256(uint64_t seed, uint64_t stream = 0) {
+        for (auto &word : s) {
+            uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+        while (stream--) jump();
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // top 53 bits, uniform in [0, 1)
+    double nextDouble() {
+        return (next() >> 11) * 0x1.0p-53;
+    }
+
+    void jump() {
+        static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        advance(JUMP);
+    }
+
+    void longJump() {
+        static const uint64_t LONG_JUMP[] = {0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+                                             0x77710069854ee241ULL, 0x39109bb02acbe635ULL};
+        advance(LONG_JUMP);
+    }
+};
+
+// Set of combination codes already generated. Small combination spaces get one bit per
+// code; bigger ones an open-addressing table (linear probing, kept at most half full).
+class ComboSet {
+private:
+    static constexpr uint64_t EMPTY = ~0ULL;
+
+    vector<uint64_t> bits;
+    vector<uint64_t> slots;
+    size_t count = 0;
+
+    void grow() {
+        vector<uint64_t> old(max<size_t>(16, slots.size() * 2), EMPTY);
+        old.swap(slots);
+        count = 0;
+        for (uint64_t code : old)
+            if (code != EMPTY) insert(code);
+    }
+
+public:
+    static constexpr uint64_t DENSE_LIMIT = 1ULL << 27;  // 16MB of bits
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    // codes are < maxComb, so EMPTY can never be a real code
+    explicit ComboSet(uint64_t maxComb) {
+        if (maxComb <= DENSE_LIMIT) bits.resize((maxComb + 63) / 64);
+        else grow();
+    }
+
+    // true if code was not in the set yet. In bitset mode only word code / 64 is touched,
+    // so threads that own disjoint words may insert concurrently.
+    bool insert(uint64_t code) {
+        if (!bits.empty()) {
+            uint64_t mask = 1ULL << (code & 63);
+            if (bits[code >> 6] & mask) return false;
+            bits[code >> 6] |= mask;
+            return true;
+        }
+        if (2 * (count + 1) > slots.size()) grow();
+        size_t i = mix(code) & (slots.size() - 1);
+        while (slots[i] != EMPTY) {
+            if (slots[i] == code) return false;
+            i = (i + 1) & (slots.size() - 1);
+        }
+        slots[i] = code;
+        count++;
+        return true;
+    }
 };
 
 class NFTGenerator {
 private:
     vector<Trait> traits;
+    shared_ptr<NFTSchema> schema;
     vector<double> randoms;
     int randIdx = 0;
+    optional<Xoshiro256> rng;  // set when seeded, then randoms is unused
+    uint64_t seed = 0, stream = 0;
+    Sampling sampling;
+
+    // With constraints, traits linked by a rule are drawn together: a block's joint trait has
+    // one value per allowed combination of its traits, weighted by the product of their
+    // weights, so one draw gives all of them and nothing is ever rejected. Unconstrained
+    // traits are blocks of one. Empty when there are no constraints.
+    struct Block {
+        vector<int> traits;
+        Trait joint;
+        vector<uint16_t> combos;  // joint value j -> picks combos[j * traits.size() + k]
+    };
+    vector<Block> blocks;
+    static constexpr uint64_t BLOCK_LIMIT = 1ULL << 20;
 
     double nextRandom() {
+        if (rng)
+            return rng->nextDouble();
         if (randIdx >= randoms.size())
             throw runtime_error("Ran out of random numbers");
         return randoms[randIdx++];
@@ -28,56 +397,504 @@ private:
         double sum = 0.0;
         for (auto &v : trait.values) sum += v.weight;
 
+        trait.cdf.clear();
         double cumulative = 0.0;
         for (auto &v : trait.values) {
             cumulative += v.weight / sum;
             trait.cdf.push_back(cumulative);
         }
+        // rounding can leave the last entry just under 1, and r = 0.9999... would fall off the end
+        trait.cdf.back() = 1.0;
     }
 
-    string selectValue(const Trait &trait) {
-        double r = nextRandom();
+    // Vose's alias method: scale weights so they average 1, then pair every
+    // under-full slot with an over-full one that tops it up.
+    void buildAlias(Trait &trait) {
+        int k = trait.values.size();
+        double sum = 0.0;
+        for (auto &v : trait.values) sum += v.weight;
+
+        trait.prob.assign(k, 1.0);
+        trait.alias.resize(k);
+        iota(trait.alias.begin(), trait.alias.end(), 0);
+
+        vector<double> scaled(k);
+        vector<int> small, large;
+        for (int i = 0; i < k; i++) {
+            scaled[i] = trait.values[i].weight * k / sum;
+            (scaled[i] < 1.0 ? small : large).push_back(i);
+        }
+        while (!small.empty() && !large.empty()) {
+            int s = small.back(), l = large.back();
+            small.pop_back();
+            trait.prob[s] = scaled[s];
+            trait.alias[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // whatever is left is 1 up to rounding and keeps prob 1
+    }
+
+    int selectIndex(const Trait &trait) {
+        return selectIndex(trait, nextRandom());
+    }
+
+    int selectIndex(const Trait &trait, double r) const {
+        if (sampling == Sampling::Alias) {
+            // one uniform does both jobs: integer part picks the slot, fraction the coin
+            int k = trait.values.size();
+            double u = r * k;
+            int slot = min((int)u, k - 1);
+            return u - slot < trait.prob[slot] ? slot : trait.alias[slot];
+        }
         auto it = lower_bound(trait.cdf.begin(), trait.cdf.end(), r);
-        int idx = it - trait.cdf.begin();
-        return trait.values[idx].name;
+        return it - trait.cdf.begin();
+    }
+
+    void buildTables() {
+        schema = make_shared<NFTSchema>();
+        for (auto &t : traits) {
+            if (t.values.size() > 65536)
+                throw invalid_argument("Trait " + t.name + " has more values than a column can index");
+            buildCDF(t);
+            buildAlias(t);
+            schema->traitNames.push_back(t.name);
+            schema->valueNames.emplace_back();
+            for (auto &v : t.values)
+                schema->valueNames.back().push_back(v.name);
+        }
+    }
+
+    uint64_t combinationCount(bool &fits) const {
+        uint64_t maxComb = 1;
+        fits = true;
+        for (auto &t : traits)
+            fits = fits && !__builtin_mul_overflow(maxComb, (uint64_t)t.values.size(), &maxComb);
+        return maxComb;
+    }
+
+    // NFTs the constraints allow; without constraints that is every combination
+    uint64_t validCount(bool &fits) const {
+        if (blocks.empty())
+            return combinationCount(fits);
+        uint64_t count = 1;
+        fits = true;
+        for (auto &b : blocks)
+            fits = fits && !__builtin_mul_overflow(count, (uint64_t)b.joint.values.size(), &count);
+        return count;
+    }
+
+    // Value indices of one NFT, drawing randoms from next(). Returns the NFT's code: the
+    // mixed-radix number of its value indices, or with constraints of its blocks' joint values,
+    // so codes stay below validCount() and sets of them need no room for forbidden NFTs.
+    template <typename R>
+    uint64_t drawPicks(vector<int> &picks, R &&next) const {
+        uint64_t code = 0;
+        if (blocks.empty()) {
+            for (size_t t = 0; t < traits.size(); t++) {
+                picks[t] = selectIndex(traits[t], next());
+                code = code * traits[t].values.size() + picks[t];
+            }
+            return code;
+        }
+        for (auto &b : blocks) {
+            int j = selectIndex(b.joint, next());
+            code = code * b.joint.values.size() + j;
+            for (size_t k = 0; k < b.traits.size(); k++)
+                picks[b.traits[k]] = b.combos[j * b.traits.size() + k];
+        }
+        return code;
+    }
+
+    // inverse of the code drawPicks() returns
+    void unpack(uint64_t code, vector<int> &picks) const {
+        if (blocks.empty()) {
+            for (size_t t = traits.size(); t-- > 0;) {
+                picks[t] = code % traits[t].values.size();
+                code /= traits[t].values.size();
+            }
+            return;
+        }
+        for (size_t i = blocks.size(); i-- > 0;) {
+            const Block &b = blocks[i];
+            size_t j = code % b.joint.values.size();
+            code /= b.joint.values.size();
+            for (size_t k = 0; k < b.traits.size(); k++)
+                picks[b.traits[k]] = b.combos[j * b.traits.size() + k];
+        }
+    }
+
+    map<string, string> toMap(const vector<int> &picks) const {
+        map<string, string> nft;
+        for (size_t t = 0; t < traits.size(); t++)
+            nft[traits[t].name] = traits[t].values[picks[t]].name;
+        return nft;
     }
 
 public:
     NFTGenerator(const vector<Trait> &traits,
-                 const vector<double> &randoms)
-        : traits(traits), randoms(randoms) {}
+                 const vector<double> &randoms,
+                 Sampling sampling = Sampling::CDF)
+        : traits(traits), randoms(randoms), sampling(sampling) {
+        buildTables();
+    }
 
-    vector<map<string, string>> generate(int n) {
-        set<string> seen;
-        vector<map<string, string>> result;
+    // Seeded mode: draws from its own PRNG and never runs out. The same (seed, stream) gives
+    // the same NFTs; separate streams give independent ones, e.g. one stream per range of a
+    // collection. No fixed random sequence to match here, so alias sampling is the default.
+    NFTGenerator(const vector<Trait> &traits,
+                 uint64_t seed,
+                 uint64_t stream = 0,
+                 Sampling sampling = Sampling::Alias)
+        : traits(traits), rng(in_place, seed, stream), seed(seed), stream(stream), sampling(sampling) {
+        buildTables();
+    }
 
-        long long maxComb = 1;
-        for (auto &t : traits)
-            maxComb *= t.values.size();
+    // Draws a value index for trait t without building an NFT, used by the benchmark
+    int draw(int t) {
+        return selectIndex(traits[t]);
+    }
 
-        int attempts = 0;
-        int maxAttempts = min((long long)randoms.size(), maxComb * 2);
+    // Replaces the constraint set. Traits joined by rules (directly or through each other)
+    // become one block; throws, keeping the old set, if a block has over BLOCK_LIMIT
+    // combinations to enumerate or if the rules leave no valid NFT.
+    void setConstraints(const vector<Constraint> &rules) {
+        vector<Block> oldBlocks = move(blocks);
+        blocks.clear();
+        try {
+            compileConstraints(rules);
+        } catch (...) {
+            blocks = move(oldBlocks);
+            throw;
+        }
+    }
+
+private:
+    void compileConstraints(const vector<Constraint> &rules) {
+        if (rules.empty()) return;
+
+        auto traitOf = [&](const string &name) {
+            for (size_t t = 0; t < traits.size(); t++)
+                if (traits[t].name == name) return (int)t;
+            throw invalid_argument("Unknown trait " + name);
+        };
+        auto valuesOf = [&](int t, const string &value) {
+            vector<int> result;
+            for (size_t v = 0; v < traits[t].values.size(); v++)
+                if (value.empty() || traits[t].values[v].name == value) result.push_back(v);
+            if (result.empty()) throw invalid_argument("Unknown value " + value + " of " + traits[t].name);
+            return result;
+        };
 
-        while (result.size() < n && attempts < maxAttempts) {
+        // (trait, value, other trait, other value) never together; values fit 16 bits
+        unordered_set<uint64_t> forbidden;
+        auto pairKey = [&](int a, int va, int b, int vb) {
+            return (uint64_t(a) * traits.size() + b) << 32 | uint64_t(va) << 16 | uint64_t(vb);
+        };
+
+        vector<int> parent(traits.size());
+        iota(parent.begin(), parent.end(), 0);
+        function<int(int)> root = [&](int t) { return parent[t] == t ? t : parent[t] = root(parent[t]); };
+
+        for (auto &rule : rules) {
+            int a = traitOf(rule.trait), b = traitOf(rule.other);
+            if (a == b) throw invalid_argument("Constraint relates " + rule.trait + " to itself");
+            vector<int> others = valuesOf(b, rule.otherValue);
+            if (rule.kind == Constraint::Requires) {
+                // requiring other=x forbids every other value of it
+                vector<int> rest;
+                for (size_t v = 0; v < traits[b].values.size(); v++)
+                    if (find(others.begin(), others.end(), v) == others.end()) rest.push_back(v);
+                others = rest;
+            }
+            for (int va : valuesOf(a, rule.value))
+                for (int vb : others)
+                    forbidden.insert(pairKey(a, va, b, vb));
+            parent[root(a)] = root(b);
+        }
+
+        map<int, vector<int>> groups;  // keyed by root, members ascending
+        for (size_t t = 0; t < traits.size(); t++)
+            groups[root(t)].push_back(t);
+        vector<vector<int>> members;
+        for (auto &g : groups) members.push_back(g.second);
+        sort(members.begin(), members.end());  // blocks in order of their first trait
+
+        vector<int> picks(traits.size());
+        for (auto &m : members) {
+            Block b;
+            b.traits = m;
+            uint64_t combos = 1;
+            for (int t : m)
+                if (__builtin_mul_overflow(combos, (uint64_t)traits[t].values.size(), &combos) ||
+                    combos > BLOCK_LIMIT)
+                    throw invalid_argument("Constrained traits around " + traits[m[0]].name +
+                                           " have too many combinations");
+
+            // odometer over the block's traits, keeping the combinations no rule forbids;
+            // every rule is between two traits of one block, so only those pairs are looked up
+            auto allowed = [&] {
+                for (int x : m)
+                    for (int y : m)
+                        if (x != y && forbidden.count(pairKey(x, picks[x], y, picks[y]))) return false;
+                return true;
+            };
+            for (int t : m) picks[t] = 0;
+            for (uint64_t c = 0; c < combos; c++) {
+                if (allowed()) {
+                    double weight = 1.0;
+                    for (int t : m) {
+                        weight *= traits[t].values[picks[t]].weight;
+                        b.combos.push_back(picks[t]);
+                    }
+                    b.joint.values.push_back({"", weight});
+                }
+                for (size_t k = m.size(); k-- > 0;) {
+                    if (++picks[m[k]] < (int)traits[m[k]].values.size()) break;
+                    picks[m[k]] = 0;
+                }
+            }
+            if (b.joint.values.empty())
+                throw invalid_argument("Constraints exclude every NFT");
+            buildCDF(b.joint);
+            buildAlias(b.joint);
+            blocks.push_back(move(b));
+        }
+    }
+
+    // Calls accept(picks) for up to n unique value-index tuples, in draw order
+    template <typename F>
+    void sampleUnique(int n, F &&accept) {
+        // an NFT is one code below the number of valid NFTs (see drawPicks)
+        bool fits;
+        uint64_t space = validCount(fits);
+
+        // too many traits for 64 bits (the spec allows 13k): dedup on the index tuples instead
+        optional<ComboSet> seen;
+        set<vector<int>> seenTuples;
+        if (fits) seen.emplace(space);
+
+        long long attempts = 0;
+        long long maxAttempts = rng ? LLONG_MAX : (long long)randoms.size();
+        if (fits && space <= (uint64_t)LLONG_MAX / 2)
+            maxAttempts = min(maxAttempts, (long long)space * 2);
+
+        vector<int> picks(traits.size());
+        int found = 0;
+        while (found < n && attempts < maxAttempts) {
             attempts++;
-            map<string, string> nft;
-            string signature;
+            uint64_t code;
 
             try {
-                for (auto &trait : traits) {
-                    string val = selectValue(trait);
-                    nft[trait.name] = val;
-                    signature += trait.name + ":" + val + "|";
-                }
+                code = drawPicks(picks, [&] { return nextRandom(); });
             } catch (...) {
                 break;
             }
 
-            if (seen.insert(signature).second) {
-                result.push_back(nft);
+            if (fits ? seen->insert(code) : seenTuples.insert(picks).second) {
+                found++;
+                accept(picks);
             }
         }
+    }
 
+public:
+    vector<map<string, string>> generate(int n) {
+        vector<map<string, string>> result;
+        sampleUnique(n, [&](const vector<int> &picks) { result.push_back(toMap(picks)); });
+        return result;
+    }
+
+    // Same NFTs as generate(), stored as columns
+    NFTCollection generateColumnar(int n) {
+        NFTCollection result(schema);
+        sampleUnique(n, [&](const vector<int> &picks) { result.append(picks); });
+        return result;
+    }
+
+    // Same NFTs as generate(), handed to sink batchSize at a time so a collection can be
+    // written out without ever being held in memory
+    void generateBatches(int n, size_t batchSize, const function<void(const NFTCollection &)> &sink) {
+        if (batchSize == 0)
+            throw invalid_argument("Batch size must be positive");
+        NFTCollection batch(schema);
+        sampleUnique(n, [&](const vector<int> &picks) {
+            batch.append(picks);
+            if (batch.size() == batchSize) {
+                sink(batch);
+                batch.clear();
+            }
+        });
+        if (batch.size()) sink(batch);
+    }
+
+    // min(n, valid NFTs) distinct NFTs. Meant for n close to the size of the space, where
+    // generate() keeps redrawing combinations it already has. Every valid NFT gets one random u
+    // and the n with the smallest log(-log u) - log(weight) win (Efraimidis-Spirakis): the same
+    // as drawing by weight, removing each pick, and drawing again, which is also what generate()
+    // does. The space is enumerated as an odometer over the traits (or over the constraint
+    // blocks, so forbidden NFTs are never visited), which is O(n) as long as n is at least
+    // 1/SPARSE of it. Below that generate() is tried first; it rarely draws a duplicate there,
+    // but it gives up after 2x space draws, so with very skewed weights it can come up short.
+    // Then the draw is redone by enumeration if the space has at most ENUMERATE_LIMIT NFTs;
+    // beyond that (or past 64 bits) the short result is returned as is.
+    // With external randoms only the NFTs that got one take part, so running out returns
+    // fewer, as generate() does.
+    vector<map<string, string>> generateDistinct(int n) {
+        static constexpr uint64_t SPARSE = 8;
+        static constexpr uint64_t ENUMERATE_LIMIT = 1ULL << 24;
+        bool fits;
+        uint64_t space = validCount(fits);
+        size_t want = min<uint64_t>(max(n, 0), fits ? space : UINT64_MAX);
+        if (!fits || space / SPARSE > want) {
+            auto result = generate(n);
+            if (result.size() == want || !fits || !rng || space > ENUMERATE_LIMIT)
+                return result;
+        }
+        return distinctByKeys(want, space);
+    }
+
+private:
+    // Efraimidis-Spirakis over all space valid NFTs, see generateDistinct. Keys are trimmed back
+    // to the best take whenever 2x take have piled up, so memory is O(take), not O(space).
+    vector<map<string, string>> distinctByKeys(size_t take, uint64_t space) {
+        // the odometer's digits: one per trait, or one per block (its joint trait)
+        vector<const Trait *> units;
+        if (blocks.empty())
+            for (auto &t : traits) units.push_back(&t);
+        else
+            for (auto &b : blocks) units.push_back(&b.joint);
+        vector<vector<double>> logWeight;
+        for (auto *u : units) {
+            logWeight.emplace_back();
+            for (auto &v : u->values) logWeight.back().push_back(log(v.weight));
+        }
+
+        vector<pair<double, uint64_t>> keys;
+        auto trim = [&] {
+            if (keys.size() <= take) return;
+            nth_element(keys.begin(), keys.begin() + take, keys.end());
+            keys.resize(take);
+        };
+        keys.reserve(min<uint64_t>(space, 2 * take + 1));
+        try {
+            for (uint64_t code = 0; code < space; code++) {
+                double lw = 0.0;
+                uint64_t rest = code;
+                for (size_t u = units.size(); u-- > 0;) {
+                    lw += logWeight[u][rest % units[u]->values.size()];
+                    rest /= units[u]->values.size();
+                }
+                keys.push_back({min(log(-log(nextRandom())) - lw, DBL_MAX), code});
+                if (keys.size() > 2 * take) trim();
+            }
+        } catch (const runtime_error &) {
+            // out of external randoms
+        }
+        trim();
+        sort(keys.begin(), keys.end());  // order of the equivalent sequential draws
+
+        // the odometer's codes are the ones drawPicks() gives
+        vector<map<string, string>> result;
+        result.reserve(keys.size());
+        vector<int> picks(traits.size());
+        for (auto [key, code] : keys) {
+            unpack(code, picks);
+            result.push_back(toMap(picks));
+        }
+        return result;
+    }
+
+public:
+    // generate() spread over threads, seeded mode only (one external sequence can't be split).
+    // Runs in rounds, each with three parallel phases:
+    //   1. thread t draws a fixed quota of codes from its own stream and buckets them by shard
+    //   2. shard s walks its buckets in (thread, draw) order and keeps the codes it hasn't seen
+    //   3. survivors are concatenated in (thread, draw) order and turned into maps
+    // Which duplicate wins never depends on timing, so a seed and thread count always give
+    // the same collection in the same order.
+    vector<map<string, string>> generateParallel(int n, int threads) {
+        bool fits;
+        uint64_t space = validCount(fits);
+        if (!rng || !fits || threads <= 1)
+            return generate(n);
+
+        // small spaces share one bitset and shard by word; big ones get a hash set per shard
+        int shards = threads * 4;
+        bool dense = space <= ComboSet::DENSE_LIMIT;
+        vector<ComboSet> seen;
+        if (dense) seen.emplace_back(space);
+        else seen.assign(shards, ComboSet(~0ULL));
+        auto shardOf = [&](uint64_t code) {
+            return dense ? (code >> 6) % shards : ComboSet::mix(code) % shards;
+        };
+
+        // thread t draws from this generator's (seed, stream) long-jumped t + 1 times, so no
+        // thread repeats what generate() on the same stream, or on any other stream, would draw
+        vector<Xoshiro256> streams;
+        Xoshiro256 base(seed, stream);
+        for (int t = 0; t < threads; t++) {
+            base.longJump();
+            streams.push_back(base);
+        }
+
+        auto parallelFor = [&](int count, auto &&body) {
+            vector<thread> pool;
+            for (int w = 1; w < threads; w++)
+                pool.emplace_back([&, w] { for (int i = w; i < count; i += threads) body(i); });
+            for (int i = 0; i < count; i += threads) body(i);
+            for (auto &th : pool) th.join();
+        };
+
+        size_t target = max(n, 0);
+        vector<uint64_t> accepted;
+        long long attempts = 0;
+        long long maxAttempts = space <= (uint64_t)LLONG_MAX / 2 ? (long long)space * 2 : LLONG_MAX;
+        vector<vector<uint64_t>> codes(threads);
+        vector<vector<vector<uint32_t>>> buckets(threads, vector<vector<uint32_t>>(shards));
+        vector<vector<char>> keep(threads);
+
+        while (accepted.size() < target && attempts < maxAttempts) {
+            // a little over what is still missing, so most runs finish in one or two rounds
+            long long need = target - accepted.size();
+            long long quota = min(need + need / 8 + 1024, maxAttempts - attempts);
+            long long perThread = (quota + threads - 1) / threads;
+            attempts += perThread * threads;
+
+            parallelFor(threads, [&](int t) {
+                codes[t].resize(perThread);
+                for (auto &b : buckets[t]) b.clear();
+                vector<int> picks(traits.size());
+                for (long long i = 0; i < perThread; i++) {
+                    uint64_t code = drawPicks(picks, [&] { return streams[t].nextDouble(); });
+                    codes[t][i] = code;
+                    buckets[t][shardOf(code)].push_back(i);
+                }
+                keep[t].assign(perThread, 0);
+            });
+            parallelFor(shards, [&](int s) {
+                ComboSet &set = seen[dense ? 0 : s];
+                for (int t = 0; t < threads; t++)
+                    for (uint32_t i : buckets[t][s])
+                        keep[t][i] = set.insert(codes[t][i]);
+            });
+            for (int t = 0; t < threads && accepted.size() < target; t++)
+                for (long long i = 0; i < perThread && accepted.size() < target; i++)
+                    if (keep[t][i]) accepted.push_back(codes[t][i]);
+        }
+
+        vector<map<string, string>> result(accepted.size());
+        parallelFor(threads, [&](int t) {
+            size_t from = accepted.size() * t / threads, to = accepted.size() * (t + 1) / threads;
+            vector<int> picks(traits.size());
+            for (size_t i = from; i < to; i++) {
+                unpack(accepted[i], picks);
+                result[i] = toMap(picks);
+            }
+        });
         return result;
     }
 };
@@ -86,7 +903,8 @@ vector<map<string, string>>
 generate_nfts(
     unordered_map<string, vector<pair<string, int>>> &configTraits,
     int n,
-    vector<double> &random_numbers
+    vector<double> &random_numbers,
+    Sampling sampling = Sampling::CDF
 ) {
     vector<Trait> traits;
 
@@ -107,22 +925,213 @@ generate_nfts(
              return a.name < b.name;
          });
 
-    for (auto &t : traits) {
-        NFTGenerator dummy({}, {});
-        double sum = 0;
-        for (auto &v : t.values) sum += v.weight;
-        double c = 0;
-        for (auto &v : t.values) {
-            c += v.weight / sum;
-            t.cdf.push_back(c);
+    NFTGenerator generator(traits, random_numbers, sampling);
+    return generator.generate(n);
+};
+
+// count traits of values values each, named trait<t> and v<v>, weights drawn from 1..100
+vector<Trait> makeTraits(int count, int values, uint64_t seed) {
+    mt19937_64 rng(seed);
+    vector<Trait> traits(count);
+    for (int t = 0; t < count; t++) {
+        traits[t].name = "trait" + to_string(t);
+        for (int v = 0; v < values; v++)
+            traits[t].values.push_back({"v" + to_string(v), double(1 + rng() % 100)});
+    }
+    return traits;
+}
+
+void benchSampling(int draws) {
+    mt19937_64 rng(42);
+    uniform_real_distribution<double> uni(0.0, 1.0);
+    vector<double> randoms(draws);
+    for (auto &r : randoms) r = uni(rng);
+
+    for (int k : {4, 16, 500}) {
+        Trait t;
+        t.name = "trait";
+        for (int i = 0; i < k; i++)
+            t.values.push_back({"v" + to_string(i), double(1 + rng() % 1000)});
+
+        for (Sampling mode : {Sampling::CDF, Sampling::Alias}) {
+            NFTGenerator generator({t}, randoms, mode);
+            auto start = chrono::steady_clock::now();
+            long long checksum = 0;
+            for (int i = 0; i < draws; i++)
+                checksum += generator.draw(0);
+            double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout << k << " values, " << (mode == Sampling::CDF ? "cdf  " : "alias") << ": "
+                 << draws / secs / 1e6 << "M draws/sec (checksum " << checksum << ")" << endl;
         }
     }
+}
 
-    NFTGenerator generator(traits, random_numbers);
-    return generator.generate(n);
-};
+void benchGenerate(int count) {
+    // 10 traits x 16 values (2^40 combinations, hashed) and 5 x 16 (2^20, bitset)
+    for (auto [traitCount, n] : {pair{10, count}, pair{5, count / 2}}) {
+        vector<Trait> traits = makeTraits(traitCount, 16, 7);
+        NFTGenerator generator(traits, 7);
+        auto start = chrono::steady_clock::now();
+        auto nfts = generator.generate(n);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << traitCount << " traits: " << nfts.size() << " unique NFTs in " << secs << " s" << endl;
+    }
+}
+
+void benchDistinct(int largestTraitCount) {
+    // asking for the whole space: 3 x 16 = 4096 up to 16^largestTraitCount combinations
+    for (int traitCount : {3, largestTraitCount}) {
+        vector<Trait> traits = makeTraits(traitCount, 16, 11);
+        int n = 1 << (4 * traitCount);
+
+        for (bool distinct : {false, true}) {
+            NFTGenerator generator(traits, 11);
+            auto start = chrono::steady_clock::now();
+            auto nfts = distinct ? generator.generateDistinct(n) : generator.generate(n);
+            double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout << (distinct ? "distinct" : "rejection") << ": " << nfts.size() << " of " << n
+                 << " NFTs in " << secs << " s" << endl;
+        }
+    }
+}
+
+// order-sensitive hash of a collection, so a rerun can be checked without keeping two copies
+uint64_t hashNFTs(const vector<map<string, string>> &nfts) {
+    uint64_t h = 0;
+    for (auto &nft : nfts)
+        for (auto &[trait, value] : nft)
+            h = h * 1000003 ^ hash<string>()(trait) * 31 ^ hash<string>()(value);
+    return h;
+}
+
+void benchParallel(int n) {
+    vector<Trait> traits = makeTraits(10, 16, 13);
+    for (int threads : {1, 2, 4, 8}) {
+        NFTGenerator generator(traits, 13);
+        auto start = chrono::steady_clock::now();
+        auto nfts = generator.generateParallel(n, threads);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << threads << " threads: " << nfts.size() / secs / 1e6 << "M NFTs/sec";
+        if (threads == 4) {
+            uint64_t first = hashNFTs(nfts);
+            nfts = {};
+            NFTGenerator again(traits, 13);
+            cout << (hashNFTs(again.generateParallel(n, 4)) == first ? " (repeatable)" : " (NOT repeatable)");
+        }
+        cout << endl;
+    }
+}
+
+void benchColumnar(int n) {
+    vector<Trait> traits = makeTraits(10, 16, 17);
+    auto heap = [] { return mallinfo2().uordblks; };
+
+    for (bool columnar : {false, true}) {
+        NFTGenerator generator(traits, 17);
+        size_t before = heap();
+        auto start = chrono::steady_clock::now();
+        size_t count, held;
+        if (columnar) {
+            NFTCollection nfts = generator.generateColumnar(n);
+            count = nfts.size();
+            held = heap() - before;
+        } else {
+            auto nfts = generator.generate(n);
+            count = nfts.size();
+            held = heap() - before;
+        }
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << (columnar ? "columnar: " : "maps:     ") << count << " NFTs in " << secs << " s, "
+             << double(held) / count << " bytes/NFT" << endl;
+    }
+
+    // streaming n NFTs as JSON in batches of 64k, peak memory stays at one batch
+    filesystem::path path = filesystem::temp_directory_path() / "nfts.json";
+    NFTGenerator generator(traits, 17);
+    auto start = chrono::steady_clock::now();
+    {
+        ofstream file(path);
+        NFTWriter writer(file, NFTWriter::JSON);
+        generator.generateBatches(n, 65536, [&](const NFTCollection &batch) { writer.write(batch); });
+        writer.finish();
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "streamed " << filesystem::file_size(path) / 1e6 << " MB of JSON in " << secs << " s" << endl;
+    filesystem::remove(path);
+}
+
+void benchRarity(int n, int slice) {
+    vector<Trait> traits = makeTraits(10, 16, 19);
+    // scoring is what is measured, so fill the columns with uniform picks instead of generating
+    auto schema = make_shared<NFTSchema>();
+    for (auto &t : traits) {
+        schema->traitNames.push_back(t.name);
+        schema->valueNames.emplace_back();
+        for (auto &v : t.values) schema->valueNames.back().push_back(v.name);
+    }
+    NFTCollection nfts(schema);
+    mt19937_64 rng(19);
+    vector<int> picks(traits.size());
+    for (int i = 0; i < n; i++) {
+        for (auto &p : picks) p = rng() % 16;
+        nfts.append(picks);
+    }
 
-int main() {
+    for (auto mode : {RarityEngine::Sum, RarityEngine::Product}) {
+        auto start = chrono::steady_clock::now();
+        RarityEngine engine(nfts, mode);
+        auto top = engine.topK(nfts, 10);
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << (mode == RarityEngine::Sum ? "sum:     " : "product: ") << n / secs / 1e6
+             << "M NFTs/sec, rarest #" << top[0].second << " score " << top[0].first << endl;
+    }
+
+    // the same sum over maps of strings, on a slice
+    vector<map<string, string>> maps;
+    for (int i = 0; i < slice; i++) maps.push_back(nfts.at(i));
+    auto start = chrono::steady_clock::now();
+    map<pair<string, string>, int> counts;
+    for (auto &nft : maps)
+        for (auto &kv : nft) counts[kv]++;
+    double best = 0;
+    for (auto &nft : maps) {
+        double score = 0;
+        for (auto &kv : nft) score += double(slice) / counts[kv];
+        best = max(best, score);
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "maps:    " << slice / secs / 1e6 << "M NFTs/sec" << endl;
+}
+
+void benchConstraints(int n) {
+    vector<Trait> traits = makeTraits(10, 16, 23);
+    // trait1 has to match trait0 and trait2 may not: about 1 random tuple in 16 is valid
+    vector<Constraint> rules;
+    for (int v = 0; v < 16; v++) {
+        rules.push_back({Constraint::Requires, "trait0", "v" + to_string(v), "trait1", "v" + to_string(v)});
+        rules.push_back({Constraint::Excludes, "trait0", "v" + to_string(v), "trait2", "v" + to_string(v)});
+    }
+
+    NFTGenerator rejecting(traits, 23);
+    auto start = chrono::steady_clock::now();
+    NFTCollection drawn = rejecting.generateColumnar(n);
+    size_t valid = 0;
+    for (size_t i = 0; i < drawn.size(); i++) {
+        int v = drawn.valueIndex(i, 0);
+        valid += drawn.valueIndex(i, 1) == v && drawn.valueIndex(i, 2) != v;
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "rejection:   " << valid / secs / 1e6 << "M valid NFTs/sec (" << valid << " of " << n << " kept)" << endl;
+
+    NFTGenerator constrained(traits, 23);
+    start = chrono::steady_clock::now();
+    constrained.setConstraints(rules);
+    NFTCollection nfts = constrained.generateColumnar(n);
+    secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "constrained: " << nfts.size() / secs / 1e6 << "M valid NFTs/sec" << endl;
+}
+
+int main(int argc, char **argv) {
     unordered_map<string, vector<pair<string, int>>> configTraits = {
         {"color", {{"red", 160}, {"blue", 12}}},
         {"background", {{"sky", 54}, {"forest", 20}}}
@@ -148,5 +1157,36 @@ int main() {
         cout << endl;
     }
 
+    // seeded: same seed and stream, same NFTs; another stream, an independent batch
+    vector<Trait> traits = {{"color", {{"red", 160}, {"blue", 12}, {"green", 40}}},
+                            {"background", {{"sky", 54}, {"forest", 20}, {"desert", 30}}}};
+    for (uint64_t stream : {0, 0, 1}) {
+        NFTGenerator seeded(traits, 2024, stream);
+        cout << "stream " << stream << ":";
+        for (auto &nft : seeded.generate(3))
+            cout << " " << nft["color"] << "/" << nft["background"];
+        cout << endl;
+    }
+
+    // desert backgrounds never come with a green color
+    NFTGenerator small(traits, 2024);
+    small.setConstraints({{Constraint::Excludes, "background", "desert", "color", "green"}});
+    NFTCollection columns = small.generateColumnar(2);
+    for (auto format : {NFTWriter::JSON, NFTWriter::CSV}) {
+        NFTWriter writer(cout, format);
+        writer.write(columns);
+        writer.finish();
+    }
+
+    // a few hundred MB and seconds by default; --full runs the sizes the numbers were quoted at
+    // (1M maps is about 1 GB, the whole run a minute)
+    bool full = argc > 1 && string(argv[1]) == "--full";
+    benchSampling(full ? 5000000 : 1000000);
+    benchGenerate(full ? 1000000 : 200000);
+    benchDistinct(full ? 5 : 4);
+    benchParallel(full ? 2000000 : 250000);
+    benchColumnar(full ? 1000000 : 200000);
+    benchRarity(full ? 20000000 : 5000000, full ? 1000000 : 200000);
+    benchConstraints(full ? 1000000 : 200000);
     return 0;
 }
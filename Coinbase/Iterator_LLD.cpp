@@ -1,18 +1,35 @@
+#include <bits/stdc++.h>
+using namespace std;
+
 template <typename T>
 class Iterator{
     public:
         virtual bool hasNext()=0;
         virtual T next()=0;
+        
+        // Fills out with up to out.size() elements, returns how many. 0 means exhausted.
+        // One virtual call per batch instead of two per element; subclasses override it
+        // with a bulk copy where they can.
+        virtual size_t nextBatch(span<T> out){
+            size_t n = 0;
+            while(n<out.size() && hasNext()) out[n++] = next();
+            return n;
+        }
         virtual ~Iterator()=default;
 };
 
+// A view: iterates the caller's list without copying it, so the list must outlive
+// the iterator. Temporaries are rejected at compile time; use OwningListIterator
+// when the iterator should keep the data itself.
 class ListIterator:public Iterator<int>{
 private:    
-    vector<int> data;
-    int index = 0;
+    span<const int> data;
+    size_t index = 0;
     
 public:
+    explicit ListIterator(span<const int> list) : data(list) {}
     ListIterator(const vector<int> &list) : data(list) {}
+    ListIterator(vector<int> &&list) = delete;
     
     bool hasNext() override{
         return index<data.size();
@@ -22,11 +39,18 @@ public:
         if(!hasNext()) throw runtime_error("No more elements");
         return data[index++];
     }
+    
+    size_t nextBatch(span<int> out) override{
+        size_t n = min(out.size(), data.size()-index);
+        copy_n(data.begin()+index, n, out.begin());
+        index+=n;
+        return n;
+    }
 };
 
 class RangeIterator : public Iterator<int>{
 private:
-    int current;
+    long long current;      // wider than int so stepping past INT_MAX/INT_MIN ends the range instead of wrapping
     int end;
     int step;
     
@@ -49,36 +73,14 @@ public:
             current+=step;
             return val;         // i return current element and moved the iterator to the next step
         }
-};
-
-class ZigZagIterator : public Iterator<int>{
-private:
-    queue<Iterator*> q;
-public:
-    ZigZagIterator(const vector<vector<int>>&Lists){
-        for(const auto& list : Lists){
-            if(!list.empty()){
-                q.push(new ListIterator(list));
-            }
-        }
-    }
-    
-    bool hasNext() override{
-        return !q.empty();
-    }
-    
-    int next() override{
-        if(!hasNext()) throw runtime_error("No Next element");
-        
-        Iterator* it = q.front();
-        q.pop();
         
-        int val = it->next();
-        if(it->hasNext()){
-            q.push(it);
+        size_t nextBatch(span<int> out) override{
+            if(!hasNext()) return 0;
+            size_t n = min<long long>(out.size(), (end-current)/step + 1);
+            for(size_t i=0; i<n; i++) out[i] = current + (long long)i*step;
+            current+=(long long)n*step;
+            return n;
         }
-        return val;
-    }
 };
 
 // This solves:
@@ -87,31 +89,186 @@ public:
 // Nested zigzags
 // Future iterators not yet invented
 
+// Each source keeps a small buffer filled with nextBatch, so taking an element is an
+// array read, not two virtual calls and a queue pop/push. Sources get read up to 64
+// elements ahead of what has been handed out.
 class RoundRobinIterator : public Iterator<int>{
 private:
-    queue<Iterator*> q;
+    struct Lane{
+        Iterator<int>* it;
+        int buf[64]{};
+        size_t pos = 0, len = 0;
+    };
+    vector<Lane> lanes;         // still has elements, in round robin order
+    size_t cur = 0;             // lane whose turn it is
+    
+    int step(){
+        Lane& l = lanes[cur];
+        int val = l.buf[l.pos++];
+        if(l.pos==l.len){
+            l.pos = 0;
+            l.len = l.it->nextBatch(l.buf);
+            if(l.len==0){
+                lanes.erase(lanes.begin()+cur);     // keeps the others in order, like the queue did
+                if(cur==lanes.size()) cur = 0;
+                return val;
+            }
+        }
+        if(++cur==lanes.size()) cur = 0;
+        return val;
+    }
+
+protected:
+    RoundRobinIterator() = default;
+    
+    void add(Iterator<int>* it){
+        Lane l{it};
+        l.len = it->nextBatch(l.buf);
+        if(l.len>0) lanes.push_back(l);
+    }
+    
 public:
     RoundRobinIterator(const vector<Iterator*> &iterators){
-        for(auto it:iterators) if(it->hasNext()) q.push(it);
+        for(auto it:iterators) add(it);
     }
     
     bool hasNext() override{
-        return !q.empty();
+        return !lanes.empty();
     }
     
     int next() override{
         if(!hasNext()) throw runtime_error("No next element");
-        
-        Iterator* it =q.front();
-        q.pop();
-        
-        int val = it->next();
-        if(it->hasNext()) q.push(it);
-        return val;
+        return step();
     }
     
+    size_t nextBatch(span<int> out) override{
+        size_t n = 0;
+        while(n<out.size() && !lanes.empty()){
+            if(cur==0){
+                // whole rounds while every lane has buffered elements to spare
+                size_t rounds = (out.size()-n)/lanes.size();
+                for(auto& l:lanes) rounds = min(rounds, l.len-l.pos-1);
+                for(size_t r=0; r<rounds; r++)
+                    for(auto& l:lanes) out[n++] = l.buf[l.pos+r];
+                for(auto& l:lanes) l.pos+=rounds;
+                if(n==out.size()) break;
+            }
+            out[n++] = step();
+        }
+        return n;
+    }
+};
+
+// Opt-in owning version: keeps its own copy (or moved-in vector) and views that.
+// The storage base is built before the ListIterator base that points into it.
+struct ListStorage{
+    vector<int> list;
+};
+
+class OwningListIterator : private ListStorage, public ListIterator{
+public:
+    explicit OwningListIterator(vector<int> list)
+        : ListStorage{std::move(list)}, ListIterator(span<const int>(ListStorage::list)) {}
+    OwningListIterator(const OwningListIterator&) = delete;     // the view would still point at the original
 };
 
+// A zigzag is a round robin over one ListIterator per non-empty list. Like ListIterator
+// it only views the lists: they must outlive it, and temporaries need OwningZigZagIterator.
+class ZigZagIterator : public RoundRobinIterator{
+private:
+    vector<unique_ptr<ListIterator>> lists;
+public:
+    ZigZagIterator(const vector<vector<int>>&Lists){
+        for(const auto& list : Lists){
+            if(!list.empty()){
+                lists.push_back(make_unique<ListIterator>(list));
+                add(lists.back().get());
+            }
+        }
+    }
+    ZigZagIterator(vector<vector<int>>&&Lists) = delete;
+};
+
+struct ListsStorage{
+    vector<vector<int>> lists;
+};
+
+class OwningZigZagIterator : private ListsStorage, public ZigZagIterator{
+public:
+    explicit OwningZigZagIterator(vector<vector<int>> lists)
+        : ListsStorage{std::move(lists)}, ZigZagIterator(ListsStorage::lists) {}
+    OwningZigZagIterator(const OwningZigZagIterator&) = delete;
+};
+
+// Drains 10M ints through Round Robin(list, range, zigzag) one element at a time
+// and in batches
+void benchBatch(){
+    const int n = 10000000;
+    vector<int> big(n/2);
+    iota(big.begin(), big.end(), 0);
+    vector<vector<int>> lists(4, vector<int>(n/16, 7));
+    
+    for(bool batched : {false, true}){
+        double ms = 1e18;
+        long long sum = 0, count = 0;
+        for(int run=0; run<5; run++){     // best of 5 runs
+            ListIterator list(big);
+            RangeIterator range(0, n/4-1, 1);
+            ZigZagIterator zigzag(lists);
+            RoundRobinIterator rr({&list, &range, &zigzag});
+        
+            auto start = chrono::steady_clock::now();
+            sum = 0, count = 0;
+            if(batched){
+                int buf[1024];
+                for(size_t got; (got = rr.nextBatch(buf))>0; count+=got)
+                    for(size_t i=0; i<got; i++) sum+=buf[i];
+            } else {
+                for(; rr.hasNext(); count++) sum+=rr.next();
+            }
+            ms = min(ms, chrono::duration<double, milli>(chrono::steady_clock::now()-start).count());
+        }
+        cout<<(batched ? "nextBatch:     " : "hasNext/next:  ")<<count<<" elements in "<<ms<<" ms (sum "<<sum<<")"<<endl;
+    }
+}
+
+// Resident memory in MB, from /proc
+double rssMB(){
+    ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm>>pages>>resident;
+    return resident*(sysconf(_SC_PAGESIZE)/1048576.0);
+}
+
+// 64 MiB of ints drained through a ListIterator and a 16-list ZigZagIterator, as views
+// and as the owning copies every iterator used to make. Kept small enough to run anywhere:
+// source, lists and one copy peak around 200 MB
+void benchViews(){
+    const size_t n = (64ull<<20)/sizeof(int);
+    vector<int> big(n);
+    iota(big.begin(), big.end(), 0);
+    vector<vector<int>> lists(16);
+    for(size_t i=0; i<16; i++) lists[i].assign(big.begin()+i*(n/16), big.begin()+(i+1)*(n/16));
+    
+    auto drain = [](const char* label, auto make){
+        double before = rssMB();
+        auto start = chrono::steady_clock::now();
+        auto it = make();
+        double built = chrono::duration<double, milli>(chrono::steady_clock::now()-start).count();
+        double extra = rssMB()-before;
+        long long sum = 0;
+        int buf[1024];
+        for(size_t got; (got = it->nextBatch(buf))>0;)
+            for(size_t i=0; i<got; i++) sum+=buf[i];
+        double total = chrono::duration<double, milli>(chrono::steady_clock::now()-start).count();
+        cout<<label<<"built in "<<built<<" ms, +"<<extra<<" MB, drained in "<<total<<" ms (sum "<<sum<<")"<<endl;
+    };
+    drain("list view:      ", [&]{ return make_unique<ListIterator>(big); });
+    drain("list owning:    ", [&]{ return make_unique<OwningListIterator>(big); });
+    drain("zigzag view:    ", [&]{ return make_unique<ZigZagIterator>(lists); });
+    drain("zigzag owning:  ", [&]{ return make_unique<OwningZigZagIterator>(lists); });
+}
+
 int main(){
     
     cout<<"Level 3: Simple List Iterator"<<endl;
@@ -130,16 +287,16 @@ int main(){
         cout<<"Next Element in range :"<<rangeList->next()<<endl;
     }
     
-    Iterator<int>* zigzagIterator = new ZigZagIterator({{1, 2, 3}, {4}, {}, {5, 6, 7, 8}});
+    Iterator<int>* zigzagIterator = new OwningZigZagIterator({{1, 2, 3}, {4}, {}, {5, 6, 7, 8}});
     while(zigzagIterator->hasNext()){
         cout<<"Next zig-zag element :"<<zigzagIterator->next()<<endl;
     }
     
     cout<<"Leavel 5: Round Robin Iterator over Mixed Iterators"<<endl;
     
-    Iterator<int>* listIt2 = new ListIterator({1, 2, 3});
+    Iterator<int>* listIt2 = new OwningListIterator({1, 2, 3});
     Iterator<int>* RangeIt2 = new RangeIterator(80, 40, -10);
-    Iterator<int>* ListIt3 = new ZigZagIterator({{1, 2, 3}, {34, 5}, {}, {32531, 532}});
+    Iterator<int>* ListIt3 = new OwningZigZagIterator({{1, 2, 3}, {34, 5}, {}, {32531, 532}});
     
     vector<Iterator<int>*> mixedIterators={
         listIt2, RangeIt2, ListIt3
@@ -150,4 +307,7 @@ int main(){
     while(rrIt->hasNext()){
         cout<<"Next Iterator:"<<rrIt->next()<<endl;
     }
+    
+    benchBatch();
+    benchViews();
 };
\ No newline at end of file
@@ -2,19 +2,32 @@
 #include <stdexcept>
 #include <vector>
 #include <unordered_map> 
+#include <memory>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <thread>
 
-class Directory; // Forward declaration // to break the cycle of child-parent-child calling each other
-// also this tell the compiler "Trust me it exist"
+// Nodes are shared between the live tree and every snapshot taken of it, so a node can have
+// several parents and keeps none. Whoever walks the tree carries the path down instead.
 
 class Node{
 protected:                          // so that child can use/modify them without getters
     std::string name;              // name we can copy it not that expensive
-    Directory * parent;           // every file/Directory should know their parent
-    // Forward Declared Directory so that Node do not screem that it do not exist
     
 public:
     // here we'll have construtor, distroyer, getters and setters
-    Node(const std::string &name, Directory* parent) : name(std::move(name)), parent(parent) {}
+    explicit Node(const std::string &name) : name(name) {}
     
     virtual ~Node()=default;    // letting compiler use default behaviour to delete Node
     
@@ -22,21 +35,152 @@ public:
         return name;
     }
     
-    Directory *getParent() const{
-        return parent;
+    void setName(const std::string &newName){   // only on a node private to the live tree
+        name = newName;
     }
     
     virtual bool isFile() const=0;      // virtually declared here to make sure who so ever extends this Class should have these methods for sure.
     virtual size_t getSize() const=0;
+    virtual std::shared_ptr<Node> clone() const=0;  // shallow: a copied directory shares its children
+};
+
+// ----------- Tiered storage: cold file bodies on disk, hot ones in an LRU -----------
+
+struct Extent{
+    uint64_t offset;
+    size_t length;
+    
+    bool operator==(const Extent &other) const{
+        return offset==other.offset && length==other.length;
+    }
+};
+
+struct CacheStats{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+};
+
+// Append only data file. A blob is never rewritten, so one still referenced by a snapshot
+// stays valid after the live file has moved on.
+class BlobStore{
+private:
+    std::fstream data;
+    uint64_t end = 0;
+    
+public:
+    explicit BlobStore(const std::string &path)
+        : data(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc){
+        if(!data) throw std::runtime_error("Cannot open blob store " + path);
+    }
+    
+    Extent append(const std::string &bytes){
+        data.seekp(end);
+        data.write(bytes.data(), bytes.size());
+        if(!data) throw std::runtime_error("Blob store write failed");
+        Extent e{end, bytes.size()};
+        end += bytes.size();
+        return e;
+    }
+    
+    std::string read(const Extent &e){
+        std::string bytes(e.length, '\0');
+        data.seekg(e.offset);                   // seeking also flushes pending appends
+        data.read(bytes.data(), e.length);
+        if(!data) throw std::runtime_error("Blob store read failed");
+        return bytes;
+    }
+};
+
+// Byte bounded LRU keyed by extent. The offset alone is not enough: an empty blob would
+// share its offset with whatever is appended next.
+class LRUCache{
+private:
+    struct ExtentHash{
+        size_t operator()(const Extent &e) const{
+            return std::hash<uint64_t>()(e.offset) ^ (std::hash<size_t>()(e.length) * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+    
+    size_t capacity;
+    size_t used = 0;
+    std::list<std::pair<Extent, std::string>> order;        // front = most recently used
+    std::unordered_map<Extent, std::list<std::pair<Extent, std::string>>::iterator, ExtentHash> where;
+    CacheStats counters;
+    
+public:
+    explicit LRUCache(size_t capacityBytes) : capacity(capacityBytes) {}
+    
+    const std::string* get(const Extent &key){
+        auto it = where.find(key);
+        if(it==where.end()){
+            counters.misses++;
+            return nullptr;
+        }
+        counters.hits++;
+        order.splice(order.begin(), order, it->second);
+        return &it->second->second;
+    }
+    
+    void put(const Extent &key, std::string value){
+        if(value.size()>capacity || where.count(key)) return;   // would evict everything for one use
+        used += value.size();
+        order.emplace_front(key, std::move(value));
+        where[key] = order.begin();
+        while(used>capacity){
+            used -= order.back().second.size();
+            where.erase(order.back().first);
+            order.pop_back();
+            counters.evictions++;
+        }
+    }
+    
+    const CacheStats& stats() const{
+        return counters;
+    }
+};
+
+class TieredStore{
+private:
+    BlobStore blobs;
+    LRUCache cache;
+    size_t spillThreshold;
+    
+public:
+    TieredStore(const std::string &dataFile, size_t spillThreshold, size_t cacheBytes)
+        : blobs(dataFile), cache(cacheBytes), spillThreshold(spillThreshold) {}
+    
+    size_t threshold() const{
+        return spillThreshold;
+    }
+    
+    Extent spill(const std::string &bytes){
+        Extent e = blobs.append(bytes);
+        cache.put(e, bytes);                    // just written, likely read again soon
+        return e;
+    }
+    
+    std::string load(const Extent &e){
+        if(const std::string *hot = cache.get(e)) return *hot;
+        std::string bytes = blobs.read(e);
+        cache.put(e, bytes);
+        return bytes;
+    }
+    
+    const CacheStats& stats() const{
+        return cache.stats();
+    }
 };
 
 class File : public Node{           // extends Node publically
 protected:
-    std::string content;
+    std::string content;            // resident body, empty once the file has spilled
+    std::vector<Extent> extents;    // spilled body in order, appends add an extent instead of rewriting
+    size_t size = 0;                // kept here so getSize()/listDir never touch disk
     
 public:
     // Constructor
-    File(const std::string &name, Directory *parent) : Node(name, parent) {}
+    explicit File(const std::string &name) : Node(name) {}
 
     // getters
     bool isFile() const override{
@@ -44,27 +188,138 @@ public:
     }
     
     // Setters
-    void write(const std::string &data){     // passing by reference to avoid expensive copy operation
+    void write(const std::string &data, TieredStore *tier=nullptr){     // passing by reference to avoid expensive copy operation
+        if(data.empty()) return;        // a spilled file would get a zero length extent
+        size += data.size();
+        if(tier && (!extents.empty() || content.size()+data.size() > tier->threshold())){
+            extents.push_back(tier->spill(content + data));
+            std::string().swap(content);
+            return;
+        }
         content += data;
     }
     
-    std::string read() const{
-        return content;
+    std::string read(TieredStore *tier=nullptr) const{
+        if(extents.empty()) return content;
+        if(!tier) throw std::runtime_error("File is spilled but no tiered store given");
+        std::string result;
+        result.reserve(size);
+        for(const auto &e : extents) result += tier->load(e);
+        return result;
     }
     
     size_t getSize() const override{
-        return content.size();
+        return size;
+    }
+    
+    std::shared_ptr<Node> clone() const override{
+        return std::make_shared<File>(*this);
+    }
+};
+
+// (size, path) biggest first, ties broken by path so top-N answers are deterministic
+struct LargerFirst{
+    bool operator()(const std::pair<size_t, std::string> &a, const std::pair<size_t, std::string> &b) const{
+        if(a.first!=b.first) return a.first>b.first;
+        return a.second<b.second;
+    }
+};
+
+// Persistent treap: an update path-copies O(log N) nodes and shares the rest, so a directory
+// copied for a snapshot shares its whole index in O(1) and neither side sees the other's edits.
+class SizeIndex{
+public:
+    using Entry = std::pair<size_t, std::string>;
+    
+private:
+    struct TreapNode;
+    using Ptr = std::shared_ptr<const TreapNode>;
+    struct TreapNode{
+        Entry key;
+        size_t priority;
+        Ptr left, right;
+    };
+    
+    Ptr root;
+    size_t count = 0;
+    
+    // splits into (< key, >= key), or (<= key, > key) when inclusive
+    static std::pair<Ptr, Ptr> split(const Ptr &t, const Entry &key, bool inclusive){
+        if(!t) return {nullptr, nullptr};
+        bool goesLeft = inclusive ? !LargerFirst()(key, t->key) : LargerFirst()(t->key, key);
+        if(goesLeft){
+            auto [l, r] = split(t->right, key, inclusive);
+            return {std::make_shared<const TreapNode>(TreapNode{t->key, t->priority, t->left, l}), r};
+        }
+        auto [l, r] = split(t->left, key, inclusive);
+        return {l, std::make_shared<const TreapNode>(TreapNode{t->key, t->priority, r, t->right})};
+    }
+    
+    static Ptr merge(const Ptr &a, const Ptr &b){
+        if(!a) return b;
+        if(!b) return a;
+        if(a->priority > b->priority){
+            return std::make_shared<const TreapNode>(TreapNode{a->key, a->priority, a->left, merge(a->right, b)});
+        }
+        return std::make_shared<const TreapNode>(TreapNode{b->key, b->priority, merge(a, b->left), b->right});
+    }
+    
+    // in order walk, stops once visit returns false
+    template <typename F>
+    static bool walk(const Ptr &t, F &visit){
+        if(!t) return true;
+        return walk(t->left, visit) && visit(t->key) && walk(t->right, visit);
+    }
+    
+public:
+    size_t size() const{
+        return count;
+    }
+    
+    void insert(const Entry &key){
+        auto [l, r] = split(root, key, false);
+        auto [same, rest] = split(r, key, true);
+        if(same) return;                                // already present
+        size_t priority = std::hash<std::string>()(key.second) ^ (key.first * 0x9E3779B97F4A7C15ull);
+        Ptr leaf = std::make_shared<const TreapNode>(TreapNode{key, priority, nullptr, nullptr});
+        root = merge(merge(l, leaf), rest);
+        count++;
+    }
+    
+    void erase(const Entry &key){
+        auto [l, r] = split(root, key, false);
+        auto [same, rest] = split(r, key, true);
+        if(same) count--;
+        root = merge(l, rest);
+    }
+    
+    std::vector<Entry> first(size_t n) const{
+        std::vector<Entry> result;
+        auto visit = [&](const Entry &e){
+            if(result.size()>=n) return false;
+            result.push_back(e);
+            return true;
+        };
+        walk(root, visit);
+        return result;
+    }
+    
+    std::vector<Entry> all() const{
+        return first(count);
     }
 };
 
 class Directory : public Node{
     private:
-        std::unordered_map<std::string, std::unique_ptr<Node>> children;
+        std::unordered_map<std::string, std::shared_ptr<Node>> children;
     // File/Folder name mapped to the node for O(1) lookup stores what inside sirectory immediate
-    // Directory Ows the child so unique pointer 
+    // Shared ownership: a snapshot and the live tree point at the same child until one of them writes it
+        SizeIndex largest;
+    // every file of this subtree ordered by size, so "N largest under /x" reads the first N entries
+    // instead of walking and sorting the subtree. Costs O(depth log N) per size change.
     public:
-        Directory(const std::string &name, Directory* parent=nullptr) 
-            : Node(name, parent){}
+        explicit Directory(const std::string &name) 
+            : Node(name){}
     
     bool isFile() const override{
         return false;
@@ -88,7 +343,16 @@ class Directory : public Node{
         // recursive
     }
     
-    void add(std::unique_ptr<Node> node){
+    // child we are about to modify: if anyone else (a snapshot) still holds it, swap in a private copy first.
+    // Callers walk down from an already private root, so this copies exactly the written path.
+    Node* getMutable(const std::string &name){
+        auto it = children.find(name);
+        if(it==children.end()) return nullptr;
+        if(it->second.use_count()>1) it->second = it->second->clone();
+        return it->second.get();
+    }
+    
+    void add(std::shared_ptr<Node> node){
         children[node->getName()] = std::move(node);
     }
     
@@ -96,6 +360,28 @@ class Directory : public Node{
         children.erase(name);
     }
     
+    void rename(const std::string &oldName, const std::string &newName){
+        getMutable(oldName);                    // the node is about to change, unshare it first
+        auto node = std::move(children.at(oldName));
+        children.erase(oldName);
+        node->setName(newName);
+        children[newName] = std::move(node);
+    }
+    
+    // path prefix of every indexed file changes when this subtree is renamed
+    void rekeyIndex(const std::string &oldPrefix, const std::string &newPrefix){
+        SizeIndex rekeyed;
+        for(const auto &[size, path] : largest.all()){
+            rekeyed.insert({size, newPrefix + path.substr(oldPrefix.size())});
+        }
+        largest = std::move(rekeyed);
+        for(auto &[_, child] : children){
+            if(child->isFile()) continue;
+            Node *mine = getMutable(child->getName());
+            static_cast<Directory*>(mine)->rekeyIndex(oldPrefix, newPrefix);
+        }
+    }
+    
     std::vector<std::string> list() const{
         std::vector<std::string> result;
         for(const auto&[name, _]: children){
@@ -104,13 +390,472 @@ class Directory : public Node{
         return result;
     }
     
+    // children in name order, gives traversals an order that does not depend on hashing
+    std::vector<const Node*> sortedChildren() const{
+        std::vector<const Node*> result;
+        result.reserve(children.size());
+        for(const auto&[_, child]: children){
+            result.push_back(child.get());
+        }
+        std::sort(result.begin(), result.end(), [](const Node *a, const Node *b){
+            return a->getName() < b->getName();
+        });
+        return result;
+    }
+    
+    void indexFile(size_t size, const std::string &path){
+        largest.insert({size, path});
+    }
+    
+    void unindexFile(size_t size, const std::string &path){
+        largest.erase({size, path});
+    }
+    
+    const SizeIndex& sizeIndex() const{
+        return largest;
+    }
+    
+    std::vector<std::pair<std::string, size_t>> topFiles(size_t n) const{
+        std::vector<std::pair<std::string, size_t>> result;
+        for(auto &[size, path] : largest.first(n)){
+            result.push_back({std::move(path), size});
+        }
+        return result;
+    }
+    
+    std::shared_ptr<Node> clone() const override{
+        return std::make_shared<Directory>(*this);
+    }
+    
+};
+
+std::string childPath(const std::string &dirPath, const std::string &name){
+    return dirPath=="/" ? dirPath + name : dirPath + "/" + name;
+}
+
+// every node below (and including) node, parents before children
+template <typename F>
+void forEachPath(const Node *node, const std::string &path, F &&visit){
+    visit(node, path);
+    if(node->isFile()) return;
+    for(const Node *child : static_cast<const Directory*>(node)->sortedChildren()){
+        forEachPath(child, childPath(path, child->getName()), visit);
+    }
+}
+
+// ----------- Name search: trigram postings over node names -----------
+// A query's trigrams pick a small candidate set that is verified afterwards, instead of
+// scanning every name in the tree. Names are padded with '/', which no name can contain,
+// so prefixes/suffixes get their own trigrams and a name of length L yields L trigrams.
+
+class NameIndex{
+private:
+    std::vector<std::string> paths;                     // id -> path, "" once removed
+    std::unordered_map<std::string, uint32_t> ids;      // live path -> id
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings;  // trigram -> ids, ascending
+    size_t dead = 0;
+    
+    static std::string nameOf(const std::string &path){
+        return path.substr(path.rfind('/') + 1);
+    }
+    
+    static uint32_t gram(const std::string &s, size_t i){
+        return (uint32_t(uint8_t(s[i]))<<16) | (uint32_t(uint8_t(s[i+1]))<<8) | uint8_t(s[i+2]);
+    }
+    
+    // distinct trigrams, padded for fuzzy/indexing, raw for substring queries
+    static std::vector<uint32_t> grams(const std::string &name, bool padded){
+        std::string s = padded ? "/" + name + "/" : name;
+        std::vector<uint32_t> result;
+        for(size_t i=0; i+3<=s.size(); i++) result.push_back(gram(s, i));
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+    
+    static size_t editDistance(const std::string &a, const std::string &b){
+        std::vector<size_t> row(b.size()+1);
+        for(size_t j=0; j<=b.size(); j++) row[j] = j;
+        for(size_t i=1; i<=a.size(); i++){
+            size_t diag = row[0];
+            row[0] = i;
+            for(size_t j=1; j<=b.size(); j++){
+                size_t up = row[j];
+                row[j] = std::min({row[j]+1, row[j-1]+1, diag + (a[i-1]!=b[j-1])});
+                diag = up;
+            }
+        }
+        return row[b.size()];
+    }
+    
+    // removed ids linger in postings until they outnumber live ones, then renumber everything
+    void compactIfNeeded(){
+        if(dead<1024 || dead<ids.size()) return;
+        std::vector<std::string> live;
+        for(auto &p : paths) if(!p.empty()) live.push_back(std::move(p));
+        clear();
+        for(const auto &p : live) add(p);
+    }
+    
+    template <typename F>
+    void forEachLive(F &&f) const{
+        for(uint32_t id=0; id<paths.size(); id++) if(!paths[id].empty()) f(id);
+    }
+    
+public:
+    size_t size() const{
+        return ids.size();
+    }
+    
+    void clear(){
+        paths.clear();
+        ids.clear();
+        postings.clear();
+        dead = 0;
+    }
+    
+    void add(const std::string &path){
+        if(ids.count(path)) return;
+        uint32_t id = static_cast<uint32_t>(paths.size());
+        paths.push_back(path);
+        ids[path] = id;
+        for(uint32_t g : grams(nameOf(path), true)) postings[g].push_back(id);   // ids only grow, lists stay sorted
+    }
+    
+    void remove(const std::string &path){
+        auto it = ids.find(path);
+        if(it==ids.end()) return;
+        paths[it->second].clear();
+        ids.erase(it);
+        dead++;
+        compactIfNeeded();
+    }
+    
+    // paths whose name contains needle, in path order
+    std::vector<std::string> substring(const std::string &needle) const{
+        std::vector<std::string> result;
+        auto check = [&](uint32_t id){
+            if(!paths[id].empty() && nameOf(paths[id]).find(needle)!=std::string::npos) result.push_back(paths[id]);
+        };
+        
+        auto qgrams = grams(needle, false);
+        if(qgrams.empty()){
+            forEachLive(check);                 // under 3 chars there is nothing to intersect on
+        }else{
+            std::vector<const std::vector<uint32_t>*> lists;
+            for(uint32_t g : qgrams){
+                auto it = postings.find(g);
+                if(it==postings.end()) return result;
+                lists.push_back(&it->second);
+            }
+            std::sort(lists.begin(), lists.end(), [](auto a, auto b){ return a->size() < b->size(); });
+            std::vector<uint32_t> candidates = *lists[0];
+            for(size_t i=1; i<lists.size() && !candidates.empty(); i++){
+                std::vector<uint32_t> next;
+                std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                                      std::back_inserter(next));
+                candidates.swap(next);
+            }
+            for(uint32_t id : candidates) check(id);    // trigrams match in any order, confirm the real substring
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+    
+    // up to limit paths whose name is within maxDistance edits of query, closest first
+    std::vector<std::pair<std::string, size_t>> fuzzy(const std::string &query, size_t maxDistance, size_t limit) const{
+        std::vector<std::pair<std::string, size_t>> result;
+        auto check = [&](uint32_t id){
+            if(paths[id].empty()) return;
+            std::string name = nameOf(paths[id]);
+            size_t lenGap = name.size()>query.size() ? name.size()-query.size() : query.size()-name.size();
+            if(lenGap>maxDistance) return;
+            size_t d = editDistance(query, name);
+            if(d<=maxDistance) result.push_back({paths[id], d});
+        };
+        
+        // q-gram lemma: one edit destroys at most 3 trigrams, so a match keeps >= |grams| - 3k of ours
+        auto qgrams = grams(query, true);
+        long long needed = static_cast<long long>(qgrams.size()) - 3*static_cast<long long>(maxDistance);
+        if(needed<=0){
+            forEachLive(check);
+        }else{
+            std::unordered_map<uint32_t, uint32_t> shared;
+            for(uint32_t g : qgrams){
+                auto it = postings.find(g);
+                if(it==postings.end()) continue;
+                for(uint32_t id : it->second) shared[id]++;
+            }
+            for(const auto &[id, count] : shared){
+                if(count>=needed) check(id);
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const auto &a, const auto &b){
+            return a.second!=b.second ? a.second<b.second : a.first<b.first;
+        });
+        if(result.size()>limit) result.resize(limit);
+        return result;
+    }
+};
+
+// Work stealing pool: every worker owns a deque, pushes/pops its own back (LIFO keeps the
+// subtree it just split hot in cache) and steals from the front of others (oldest = biggest subtree)
+
+class WorkStealingPool{
+private:
+    struct Worker{
+        std::deque<std::function<void()>> tasks;
+        std::mutex m;
+    };
+    
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> nextVictim{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepM;
+    std::condition_variable wake;
+    
+    // worker running on this thread; the pool is kept too, since the index means nothing to other pools
+    struct Current{
+        const WorkStealingPool *pool;
+        int id;
+    };
+    static inline thread_local Current self{nullptr, -1};
+    
+    bool popOwn(int id, std::function<void()> &task){
+        Worker &w = *workers[id];
+        std::lock_guard<std::mutex> lock(w.m);
+        if(w.tasks.empty()) return false;
+        task = std::move(w.tasks.back());
+        w.tasks.pop_back();
+        return true;
+    }
+    
+    bool steal(int id, std::function<void()> &task){
+        for(size_t i=1; i<workers.size(); i++){
+            Worker &victim = *workers[(id+i)%workers.size()];
+            std::lock_guard<std::mutex> lock(victim.m);
+            if(victim.tasks.empty()) continue;
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+    
+    void run(int id){
+        self = {this, id};
+        std::function<void()> task;
+        while(true){
+            if(popOwn(id, task) || steal(id, task)){
+                queued--;
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepM);
+            wake.wait(lock, [this]{ return stopping || queued>0; });
+            if(stopping && queued==0) return;
+        }
+    }
+    
+public:
+    explicit WorkStealingPool(size_t n = std::max(1u, std::thread::hardware_concurrency())){
+        for(size_t i=0; i<n; i++) workers.push_back(std::make_unique<Worker>());
+        for(size_t i=0; i<n; i++) threads.emplace_back([this, i]{ run(static_cast<int>(i)); });
+    }
+    
+    ~WorkStealingPool(){
+        {
+            std::lock_guard<std::mutex> lock(sleepM);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(auto &t : threads) t.join();
+    }
+    
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    
+    size_t size() const{
+        return workers.size();
+    }
+    
+    size_t pending() const{
+        return queued;
+    }
+    
+    void submit(std::function<void()> task){
+        // tasks spawned by one of our workers stay on its own deque, anyone else spreads round robin
+        int id = self.pool==this ? self.id : static_cast<int>(nextVictim++ % workers.size());
+        // count the task before it can be stolen, or the thief's decrement could wrap queued
+        {
+            std::lock_guard<std::mutex> lock(sleepM);
+            queued++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(workers[id]->m);
+            workers[id]->tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+};
+
+// Visitor for a parallel reduction over a subtree. Called concurrently from many threads,
+// so it must not keep mutable state. combine() is always applied in the same shape
+// (directory first, then children by name), so the result does not depend on scheduling.
+template <typename R>
+class TreeVisitor{
+public:
+    virtual ~TreeVisitor() = default;
+    virtual R identity() const = 0;
+    virtual R visitFile(const File &file, const std::string &path) const = 0;
+    virtual R visitDirectory(const Directory &, const std::string &) const{
+        return identity();
+    }
+    virtual R combine(R left, R right) const = 0;
+};
+
+// Fork join without blocking joins: a directory frame counts its outstanding child subtrees,
+// whoever finishes the last one folds the frame and hands the value up to its parent.
+// The tree must not be modified while a traversal is running.
+template <typename R>
+class ParallelTraversal{
+private:
+    struct Frame{
+        const Directory *dir;
+        std::string path;
+        std::vector<R> results;                 // one slot per child, folded in this order
+        std::atomic<size_t> outstanding;
+        Frame *parent;
+        size_t slot;
+    };
+    
+    const TreeVisitor<R> &visitor;
+    WorkStealingPool &pool;
+    std::promise<R> done;
+    
+    // keep a few tasks per worker queued for thieves, anything more runs inline
+    bool shouldSpawn() const{
+        return pool.pending() < 4*pool.size();
+    }
+    
+    R sequential(const Node *node, const std::string &path) const{
+        if(node->isFile()) return visitor.visitFile(*static_cast<const File*>(node), path);
+        const Directory *dir = static_cast<const Directory*>(node);
+        R acc = visitor.visitDirectory(*dir, path);
+        for(const Node *child : dir->sortedChildren()){
+            acc = visitor.combine(std::move(acc), sequential(child, childPath(path, child->getName())));
+        }
+        return acc;
+    }
+    
+    void process(const Directory *dir, std::string path, Frame *parent, size_t slot){
+        auto children = dir->sortedChildren();
+        Frame *frame = new Frame{dir, std::move(path), std::vector<R>(children.size()), {1}, parent, slot};
+        
+        for(size_t i=0; i<children.size(); i++){
+            const Node *child = children[i];
+            std::string path = childPath(frame->path, child->getName());
+            if(!child->isFile() && shouldSpawn()){
+                frame->outstanding++;
+                pool.submit([this, child, path, frame, i]{
+                    process(static_cast<const Directory*>(child), path, frame, i);
+                });
+            }else{
+                frame->results[i] = sequential(child, path);
+            }
+        }
+        release(frame);
+    }
+    
+    void release(Frame *frame){
+        while(frame && --frame->outstanding==0){
+            R acc = visitor.visitDirectory(*frame->dir, frame->path);
+            for(auto &r : frame->results){
+                acc = visitor.combine(std::move(acc), std::move(r));
+            }
+            Frame *parent = frame->parent;
+            if(parent){
+                parent->results[frame->slot] = std::move(acc);
+            }else{
+                done.set_value(std::move(acc));
+            }
+            delete frame;
+            frame = parent;
+        }
+    }
+    
+public:
+    ParallelTraversal(const TreeVisitor<R> &visitor, WorkStealingPool &pool)
+        : visitor(visitor), pool(pool){}
+    
+    R run(const Node *start, const std::string &path){
+        if(start->isFile()) return visitor.visitFile(*static_cast<const File*>(start), path);
+        auto result = done.get_future();
+        pool.submit([this, start, path]{ process(static_cast<const Directory*>(start), path, nullptr, 0); });
+        return result.get();
+    }
+};
+
+class SizeVisitor : public TreeVisitor<size_t>{
+public:
+    size_t identity() const override{
+        return 0;
+    }
+    size_t visitFile(const File &file, const std::string &) const override{
+        return file.getSize();
+    }
+    size_t combine(size_t left, size_t right) const override{
+        return left + right;
+    }
+};
+
+// every path whose last component contains the needle, in path order
+class NameSearchVisitor : public TreeVisitor<std::vector<std::string>>{
+private:
+    std::string needle;
+    
+    std::vector<std::string> match(const Node &node, const std::string &path) const{
+        if(node.getName().find(needle)==std::string::npos) return {};
+        return {path};
+    }
+    
+public:
+    explicit NameSearchVisitor(std::string needle) : needle(std::move(needle)){}
+    
+    std::vector<std::string> identity() const override{
+        return {};
+    }
+    std::vector<std::string> visitFile(const File &file, const std::string &path) const override{
+        return match(file, path);
+    }
+    std::vector<std::string> visitDirectory(const Directory &dir, const std::string &path) const override{
+        return match(dir, path);
+    }
+    std::vector<std::string> combine(std::vector<std::string> left, std::vector<std::string> right) const override{
+        if(left.empty()) return right;
+        left.insert(left.end(), std::make_move_iterator(right.begin()), std::make_move_iterator(right.end()));
+        return left;
+    }
 };
 
 // Facade : Path traversal lives here
 
+// A frozen tree. Taking one only bumps the root's refcount; the live tree copies a node
+// away from it the first time that node is written, so nothing in here ever changes.
+class Snapshot{
+    friend class FileSystem;
+    std::shared_ptr<Directory> root;
+    explicit Snapshot(std::shared_ptr<Directory> root) : root(std::move(root)) {}
+};
+
 class FileSystem{
 private:
-    std::unique_ptr<Directory> root;
+    std::shared_ptr<Directory> root;
+    std::unique_ptr<TieredStore> tier;          // null = every body stays in memory
+    NameIndex names;
+    bool namesStale = false;                    // set by restore(), rebuilt on the next search
     
     std::vector<std::string> split(const std::string&path){ 
         // "/user/bin/text.txt"
@@ -126,6 +871,41 @@ private:
         return parts; // as vector of string
     }
     
+    static std::string baseName(const std::string &path){
+        return path.substr(path.rfind('/') + 1);
+    }
+    
+    // a restored snapshot brings its own tree, re-derive the name index from it once
+    void refreshNames(){
+        if(!namesStale) return;
+        names.clear();
+        for(const Node *child : root->sortedChildren()){
+            forEachPath(child, childPath("/", child->getName()), [this](const Node*, const std::string &p){ names.add(p); });
+        }
+        namesStale = false;
+    }
+    
+    std::string join(const std::vector<std::string> &parts){
+        std::string path;
+        for(const auto &p : parts) path += "/" + p;
+        return path.empty() ? "/" : path;
+    }
+    
+    // directories from root down to the parent of parts.back(), each made private to the
+    // live tree on the way (path copying) so the caller may modify any of them
+    std::vector<Directory*> mutablePathToParent(const std::vector<std::string> &parts){
+        if(root.use_count()>1) root = std::static_pointer_cast<Directory>(root->clone());
+        std::vector<Directory*> chain{root.get()};
+        for(size_t i=0; i+1<parts.size(); i++){
+            Node* next = chain.back()->get(parts[i]);
+            if(!next || next->isFile()){
+                throw std::runtime_error("Invalid Path");
+            }
+            chain.push_back(static_cast<Directory*>(chain.back()->getMutable(parts[i])));
+        }
+        return chain;
+    }
+    
     Directory* traverseToParent(const std::vector<std::string> &parts){
         Directory* curr = root.get();
         for(size_t i=0; i+1<parts.size(); i++){
@@ -138,44 +918,202 @@ private:
         return curr;
     }
     
+    Node* traverse(const std::vector<std::string> &parts){
+        Node* curr = root.get();
+        for(const auto &p : parts){
+            if(curr->isFile()) return nullptr;
+            curr = static_cast<Directory*>(curr)->get(p);
+            if(!curr) return nullptr;
+        }
+        return curr;
+    }
+    
 public:
     FileSystem(){
-        root=std::make_unique<Directory>("/");
+        root=std::make_shared<Directory>("/");
+    }
+    
+    // bodies written past spillThreshold bytes go to dataFile from now on, cacheBytes of them stay hot
+    void enableTiering(const std::string &dataFile, size_t spillThreshold, size_t cacheBytes){
+        if(tier) throw std::runtime_error("Tiering already enabled");
+        tier = std::make_unique<TieredStore>(dataFile, spillThreshold, cacheBytes);
+    }
+    
+    CacheStats tierStats() const{
+        return tier ? tier->stats() : CacheStats{};
+    }
+    
+    // O(1): later writes path-copy away from the snapshot instead of touching it
+    Snapshot snapshot() const{
+        return Snapshot(root);
+    }
+    
+    // O(1) as well, the snapshot stays valid and can be restored again
+    void restore(const Snapshot &snap){
+        root = snap.root;
+        namesStale = true;
     }
     
     void mkdir(const std::string &path){
         auto parts = split(path);
-        Directory* parent = traverseToParent(parts);
+        auto chain = mutablePathToParent(parts);
+        Directory* parent = chain.back();
         
         const std::string& dirName = parts.back();
         if(parent->exists(dirName)){
             throw std::runtime_error("Directory already exists");
         }
         
-        parent->add(std::make_unique<Directory>(dirName, parent));
+        parent->add(std::make_shared<Directory>(dirName));
+        if(!namesStale) names.add(join(parts));
     }
     
     void createFile(const std::string& path){
         auto parts = split(path);
-        Directory* parent = traverseToParent(parts);
+        auto chain = mutablePathToParent(parts);
+        Directory* parent = chain.back();
         
         const std::string& fileName = parts.back();
         if(parent->exists(fileName)){
             throw std::runtime_error("File already exists");
         }
         
-        parent->add(std::make_unique<File>(fileName, parent));
+        parent->add(std::make_shared<File>(fileName));
+        std::string fullPath = join(parts);
+        if(!namesStale) names.add(fullPath);
+        for(Directory *dir : chain){
+            dir->indexFile(0, fullPath);        // a file's size lives in the index of every directory above it
+        }
     }
     
     void writeFile(const std::string &path, const std::string &data){
         auto parts = split(path);
-        Directory* parent = traverseToParent(parts);
+        auto chain = mutablePathToParent(parts);
+        Directory* parent = chain.back();
         
         Node* node = parent->get(parts.back());
         if(!node||!node->isFile()){
             throw std::runtime_error("File not found");
         }
-        static_cast<File*> (node)->write(data);
+        File *file = static_cast<File*> (parent->getMutable(parts.back()));
+        size_t oldSize = file->getSize();
+        file->write(data, tier.get());
+        
+        std::string fullPath = join(parts);
+        for(Directory *dir : chain){
+            dir->unindexFile(oldSize, fullPath);
+            dir->indexFile(file->getSize(), fullPath);
+        }
+    }
+    
+    void remove(const std::string &path){
+        auto parts = split(path);
+        if(parts.empty()) throw std::runtime_error("Cannot remove root");
+        auto chain = mutablePathToParent(parts);
+        Directory* parent = chain.back();
+        
+        Node* node = parent->get(parts.back());
+        if(!node){
+            throw std::runtime_error("Path not found");
+        }
+        std::vector<SizeIndex::Entry> gone;
+        if(node->isFile()){
+            gone.push_back({node->getSize(), join(parts)});
+        }else{
+            // the removed directory's own index already lists every file below it
+            gone = static_cast<Directory*>(node)->sizeIndex().all();
+        }
+        for(Directory *dir : chain){
+            for(const auto &[size, filePath] : gone){
+                dir->unindexFile(size, filePath);
+            }
+        }
+        if(!namesStale){
+            forEachPath(node, join(parts), [this](const Node*, const std::string &p){ names.remove(p); });
+        }
+        parent->remove(parts.back());
+    }
+    
+    // renames the last component in place, a directory takes its whole subtree along
+    void rename(const std::string &path, const std::string &newName){
+        auto parts = split(path);
+        if(parts.empty()) throw std::runtime_error("Cannot rename root");
+        if(newName.empty() || newName.find('/')!=std::string::npos){
+            throw std::invalid_argument("Invalid name");
+        }
+        auto chain = mutablePathToParent(parts);
+        Directory* parent = chain.back();
+        
+        Node* node = parent->get(parts.back());
+        if(!node){
+            throw std::runtime_error("Path not found");
+        }
+        if(parent->exists(newName)){
+            throw std::runtime_error("Name already exists");
+        }
+        std::string oldPath = join(parts);
+        parts.back() = newName;
+        std::string newPath = join(parts);
+        
+        std::vector<SizeIndex::Entry> moved;
+        if(node->isFile()) moved.push_back({node->getSize(), oldPath});
+        else moved = static_cast<Directory*>(node)->sizeIndex().all();
+        std::vector<std::string> oldPaths;
+        if(!namesStale){
+            forEachPath(node, oldPath, [&](const Node*, const std::string &p){ oldPaths.push_back(p); });
+        }
+        
+        parent->rename(baseName(oldPath), newName);
+        node = parent->get(newName);
+        if(!node->isFile()){
+            static_cast<Directory*>(node)->rekeyIndex(oldPath, newPath);
+        }
+        for(Directory *dir : chain){
+            for(const auto &[size, filePath] : moved){
+                dir->unindexFile(size, filePath);
+                dir->indexFile(size, newPath + filePath.substr(oldPath.size()));
+            }
+        }
+        for(const auto &p : oldPaths){
+            names.remove(p);
+            names.add(newPath + p.substr(oldPath.size()));
+        }
+    }
+    
+    // paths whose name contains needle
+    std::vector<std::string> searchName(const std::string &needle){
+        refreshNames();
+        return names.substring(needle);
+    }
+    
+    // closest names within maxDistance edits, (path, distance) closest first
+    std::vector<std::pair<std::string, size_t>> searchFuzzy(const std::string &query, size_t maxDistance=2, size_t limit=10){
+        refreshNames();
+        return names.fuzzy(query, maxDistance, limit);
+    }
+    
+    template <typename R>
+    R parallelReduce(const TreeVisitor<R> &visitor, WorkStealingPool &pool, const std::string &path="/"){
+        auto parts = split(path);
+        Node* node = traverse(parts);
+        if(!node){
+            throw std::runtime_error("Invalid Path");
+        }
+        return ParallelTraversal<R>(visitor, pool).run(node, join(parts));
+    }
+    
+    // N largest files under prefix (a directory or file path), biggest first
+    std::vector<std::pair<std::string, size_t>> getLargest(size_t n, const std::string &prefix="/"){
+        auto parts = split(prefix);
+        Node* node = traverse(parts);
+        if(!node){
+            throw std::runtime_error("Invalid Path");
+        }
+        if(node->isFile()){
+            if(n==0) return {};
+            return {{join(parts), node->getSize()}};
+        }
+        return static_cast<Directory*>(node)->topFiles(n);
     }
     
     std::string readFile(const std::string& path){
@@ -186,7 +1124,7 @@ public:
         if(!node || !node->isFile()){
             throw std::runtime_error("File not found");
         }
-        return static_cast<File* > (node)->read();
+        return static_cast<File* > (node)->read(tier.get());
     }
     
     std::vector<std::string> listDir(const std::string&path){
@@ -204,11 +1142,106 @@ public:
     }
 };
 
+// wide and deep synthetic tree, then the same reduction at 1..hardware threads
+void benchParallelTraversal(){
+    FileSystem fs;
+    const int top = 64, mid = 32, files = 64;      // ~130k files
+    for(int a=0; a<top; a++){
+        std::string da = "/d" + std::to_string(a);
+        fs.mkdir(da);
+        for(int b=0; b<mid; b++){
+            std::string db = da + "/s" + std::to_string(b);
+            fs.mkdir(db);
+            for(int c=0; c<files; c++){
+                std::string f = db + "/f" + std::to_string(c);
+                fs.createFile(f);
+                fs.writeFile(f, std::string(c+1, 'x'));
+            }
+        }
+    }
+    
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for(size_t threads=1; threads<=maxThreads; threads*=2){
+        WorkStealingPool pool(threads);
+        auto start = std::chrono::steady_clock::now();
+        size_t total = fs.parallelReduce(SizeVisitor(), pool);
+        auto hits = fs.parallelReduce(NameSearchVisitor("f63"), pool);
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout<<threads<<" threads: size="<<total<<" matches="<<hits.size()<<" "<<ms<<" ms"<<std::endl;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    auto indexed = fs.searchName("f63");
+    auto fuzzy = fs.searchFuzzy("f630", 1, 5);
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout<<"trigram index: matches="<<indexed.size()<<" fuzzy="<<fuzzy.size()<<" "<<ms<<" ms"<<std::endl;
+}
+
 int main(){
     FileSystem fs;
     fs.mkdir("/usr");
     fs.mkdir("/usr/bin");
     fs.createFile("/usr/bin/app");
     fs.writeFile("/usr/bin/app", "Hello World");
-    std::cout<<fs.readFile("/usr/bin/app");
+    std::cout<<fs.readFile("/usr/bin/app")<<std::endl;
+    
+    fs.mkdir("/usr/lib");
+    fs.createFile("/usr/lib/libc.so");
+    fs.writeFile("/usr/lib/libc.so", "0123456789012345");
+    fs.createFile("/usr/lib/libm.so");
+    fs.writeFile("/usr/lib/libm.so", "01234");
+    fs.createFile("/notes");
+    fs.writeFile("/notes", "0123456789");
+    
+    for(const auto &[path, size] : fs.getLargest(3)){
+        std::cout<<path<<" "<<size<<std::endl;
+    }
+    for(const auto &[path, size] : fs.getLargest(5, "/usr/lib")){
+        std::cout<<path<<" "<<size<<std::endl;
+    }
+    WorkStealingPool pool;
+    std::cout<<"total size "<<fs.parallelReduce(SizeVisitor(), pool)<<std::endl;
+    for(const auto &path : fs.parallelReduce(NameSearchVisitor("lib"), pool)){
+        std::cout<<path<<std::endl;
+    }
+    
+    Snapshot backup = fs.snapshot();
+    fs.remove("/usr/lib");
+    fs.writeFile("/usr/bin/app", "!!");
+    for(const auto &[path, size] : fs.getLargest(3)){
+        std::cout<<path<<" "<<size<<std::endl;
+    }
+    fs.restore(backup);
+    std::cout<<"restored: "<<fs.readFile("/usr/bin/app")<<std::endl;
+    for(const auto &[path, size] : fs.getLargest(3)){
+        std::cout<<path<<" "<<size<<std::endl;
+    }
+    
+    fs.rename("/usr", "opt");
+    for(const auto &path : fs.searchName("lib")){
+        std::cout<<"found "<<path<<std::endl;
+    }
+    for(const auto &[path, dist] : fs.searchFuzzy("libx.so", 1)){
+        std::cout<<"fuzzy "<<path<<" "<<dist<<std::endl;
+    }
+    for(const auto &[path, size] : fs.getLargest(2, "/opt")){
+        std::cout<<path<<" "<<size<<std::endl;
+    }
+    
+    FileSystem cold;
+    cold.enableTiering((std::filesystem::temp_directory_path() / "fs_blobs.dat").string(), 8, 32);
+    cold.createFile("/small");
+    cold.writeFile("/small", "tiny");
+    for(int i=0; i<4; i++){
+        std::string f = "/big" + std::to_string(i);
+        cold.createFile(f);
+        cold.writeFile(f, std::string(12, 'a'+i));
+        cold.writeFile(f, "tail");
+    }
+    std::cout<<cold.readFile("/small")<<" "<<cold.readFile("/big0")<<" "<<cold.readFile("/big3")<<std::endl;
+    std::cout<<cold.readFile("/big3")<<std::endl;
+    CacheStats stats = cold.tierStats();
+    std::cout<<"hits="<<stats.hits<<" misses="<<stats.misses<<" evictions="<<stats.evictions<<std::endl;
+    
+    benchParallelTraversal();
 }
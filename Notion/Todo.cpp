@@ -1,41 +1,558 @@
 #include <bits/stdc++.h>
+#include <fcntl.h>   // open, for the journal
+#include <malloc.h>  // mallinfo2, for the memory report
+#include <unistd.h>  // write, fdatasync
 using namespace std;
 
+// Every distinct tag string is stored once here, tasks and indexes refer to it by id
+class TagTable {
+private:
+    unordered_map<string, int> ids;
+    vector<string> names;
+
+public:
+    int intern(const string& tag) {
+        auto it = ids.find(tag);
+        if (it != ids.end())
+            return it->second;
+        names.push_back(tag);
+        return ids[tag] = names.size() - 1;
+    }
+
+    int find(const string& tag) const {  // -1 if no task ever used it
+        auto it = ids.find(tag);
+        return it == ids.end() ? -1 : it->second;
+    }
+
+    const string& name(int id) const {
+        return names[id];
+    }
+};
+
+// Fixed contents after construction; up to N elements live inline, only longer lists allocate
+template <typename T, size_t N>
+class SmallVector {
+private:
+    uint32_t count;
+    union {
+        T inlineItems[N];
+        T* heap;
+    };
+
+public:
+    template <typename It>
+    SmallVector(It first, It last) : count(distance(first, last)) {
+        T* dst = count <= N ? inlineItems : (heap = new T[count]);
+        copy(first, last, dst);
+    }
+
+    SmallVector(const SmallVector&) = delete;
+    SmallVector& operator=(const SmallVector&) = delete;
+
+    ~SmallVector() {
+        if (count > N)
+            delete[] heap;
+    }
+
+    const T* begin() const { return count <= N ? inlineItems : heap; }
+    const T* end() const { return begin() + count; }
+    size_t size() const { return count; }
+};
+
 class Task {
 public:
     int taskId;
+    int userId;  // owner, for queries that span users; fills padding, sizeof(Task) is unchanged
     string taskName;
     int dueDate;
-    unordered_set<string> tags;
+    int dueSlot = -1;  // position in its DueIndex bucket, for O(1) removal; also fills padding
+    SmallVector<int, 4> tags;  // interned tag ids, a task has only a handful
     bool finish;
 
-    Task(int id, string name, int due, vector<string>& tagList)
-        : taskId(id), taskName(name), dueDate(due), finish(false) {
-        tags.insert(tagList.begin(), tagList.end());
+    Task(int id, int user, string name, int due, const vector<int>& tagIds)
+        : taskId(id), userId(user), taskName(move(name)), dueDate(due), tags(tagIds.begin(), tagIds.end()), finish(false) {}
+};
+
+// Tasks are carved out of large chunks instead of one heap allocation each. Slots never move,
+// so a Task* stays a valid handle until destroy(); freed slots are threaded into a free list
+// through their own storage and reused before a new chunk is cut.
+template <typename T, size_t ChunkSize = 4096>
+class SlabPool {
+private:
+    union Slot {
+        Slot* nextFree;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    vector<unique_ptr<Slot[]>> chunks;
+    size_t usedInLast = ChunkSize;
+    Slot* freeList = nullptr;
+    size_t liveCount = 0;
+
+public:
+    SlabPool() = default;
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        Slot* slot;
+        if (freeList) {
+            slot = freeList;
+            freeList = freeList->nextFree;
+        } else {
+            if (usedInLast == ChunkSize) {
+                chunks.emplace_back(new Slot[ChunkSize]);
+                usedInLast = 0;
+            }
+            slot = &chunks.back()[usedInLast++];
+        }
+        liveCount++;
+        return new (slot->storage) T(forward<Args>(args)...);
+    }
+
+    void destroy(T* item) {
+        item->~T();
+        Slot* slot = reinterpret_cast<Slot*>(item);
+        slot->nextFree = freeList;
+        freeList = slot;
+        liveCount--;
     }
+
+    size_t live() const { return liveCount; }
+    size_t reservedBytes() const { return chunks.size() * ChunkSize * sizeof(Slot); }
+};
+
+// Position in a (dueDate, taskId) ordered listing, the next page starts right after it
+struct TaskCursor {
+    int dueDate;
+    int taskId;
 };
 
 struct CompareTask {
+    using is_transparent = void;  // lets the sets seek straight to a cursor
+
     bool operator()(const Task* a, const Task* b) const {
         if (a->dueDate == b->dueDate)
             return a->taskId < b->taskId;  // tie breaker
         return a->dueDate < b->dueDate;
     }
+
+    bool operator()(const Task* a, const TaskCursor& b) const {
+        return a->dueDate != b.dueDate ? a->dueDate < b.dueDate : a->taskId < b.taskId;
+    }
+
+    bool operator()(const TaskCursor& a, const Task* b) const {
+        return a.dueDate != b->dueDate ? a.dueDate < b->dueDate : a.taskId < b->taskId;
+    }
 };
 
-class TodoList {
+// Open tasks of every user bucketed by dueDate / width. A range query reads only the buckets
+// overlapping [from, to] and an overdue sweep only the buckets it has not passed yet, so
+// reminders never scan all users.
+class DueIndex {
 private:
-    int idCounter;
-    unordered_map<int, set<Task*, CompareTask>> tasks;
+    int width;
+    map<int, vector<Task*>> buckets;  // unordered inside a bucket, each task knows its slot
+    int sweptUpTo = INT_MIN;          // everything due before this was already reported
+    vector<Task*> lateArrivals;       // added after the sweep had passed their due date
+
+    int bucketOf(int due) const {
+        return due / width - (due % width < 0);  // floor, also for negatives
+    }
+
+    static void sortByDue(vector<const Task*>& out) {
+        sort(out.begin(), out.end(), CompareTask());
+    }
+
+    static void placeIn(vector<Task*>& v, Task* task) {
+        task->dueSlot = v.size();
+        v.push_back(task);
+    }
+
+    // O(1): the task's slot says where it is, the last task moves into the hole
+    static bool eraseFrom(vector<Task*>& v, Task* task) {
+        size_t slot = task->dueSlot;
+        if (slot >= v.size() || v[slot] != task)
+            return false;
+        v[slot] = v.back();
+        v[slot]->dueSlot = slot;
+        v.pop_back();
+        task->dueSlot = -1;
+        return true;
+    }
 
 public:
-    TodoList() {
-        idCounter = 1;
+    explicit DueIndex(int width) : width(width) {
+        if (width <= 0)
+            throw invalid_argument("Bucket width must be positive");
     }
 
-    int addTask(int userId, string taskDescription, int dueDate, vector<string> tags) {
-        Task* task = new Task(idCounter++, taskDescription, dueDate, tags);
-        tasks[userId].insert(task);
+    void add(Task* task) {
+        if (task->dueDate < sweptUpTo)
+            placeIn(lateArrivals, task);
+        else
+            placeIn(buckets[bucketOf(task->dueDate)], task);
+    }
+
+    void remove(Task* task) {
+        if (eraseFrom(lateArrivals, task))
+            return;
+        auto it = buckets.find(bucketOf(task->dueDate));
+        if (it == buckets.end())
+            return;
+        eraseFrom(it->second, task);
+        if (it->second.empty())
+            buckets.erase(it);
+    }
+
+    // open tasks with from <= dueDate <= to, by (dueDate, taskId)
+    vector<const Task*> range(int from, int to) const {
+        vector<const Task*> out;
+        for (auto it = buckets.lower_bound(bucketOf(from)); it != buckets.end() && it->first <= bucketOf(to); ++it)
+            for (Task* task : it->second)
+                if (task->dueDate >= from && task->dueDate <= to)
+                    out.push_back(task);
+        for (Task* task : lateArrivals)
+            if (task->dueDate >= from && task->dueDate <= to)
+                out.push_back(task);
+        sortByDue(out);
+        return out;
+    }
+
+    // open tasks that became overdue (dueDate < now) since the previous sweep; each is reported once
+    vector<const Task*> sweep(int now) {
+        vector<const Task*> out(lateArrivals.begin(), lateArrivals.end());
+        for (Task* task : lateArrivals)
+            placeIn(buckets[bucketOf(task->dueDate)], task);
+        lateArrivals.clear();
+        if (now > sweptUpTo) {
+            for (auto it = buckets.lower_bound(bucketOf(sweptUpTo)); it != buckets.end() && it->first <= bucketOf(now); ++it)
+                for (Task* task : it->second)
+                    if (task->dueDate >= sweptUpTo && task->dueDate < now)
+                        out.push_back(task);
+            sweptUpTo = now;
+        }
+        sortByDue(out);
+        return out;
+    }
+};
+
+// Compressed set of task ids, roaring style: ids are split by their high 16 bits and each
+// 64K block is a sorted uint16 array while sparse or a 1024-word bitmap once dense.
+// Word-at-a-time loops over dense blocks are plain enough for the compiler to vectorize.
+class RoaringBitmap {
+private:
+    static constexpr size_t ArrayMax = 4096;  // past this the 8KB bitmap is the smaller form
+    static constexpr size_t Words = 1024;
+
+    struct Container {
+        vector<uint16_t> array;  // sorted, while sparse
+        vector<uint64_t> bits;   // Words long, once dense
+        uint32_t card = 0;
+
+        bool dense() const { return !bits.empty(); }
+
+        bool contains(uint16_t v) const {
+            if (dense())
+                return bits[v >> 6] >> (v & 63) & 1;
+            return binary_search(array.begin(), array.end(), v);
+        }
+
+        void makeDense() {
+            bits.assign(Words, 0);
+            for (uint16_t v : array)
+                bits[v >> 6] |= uint64_t(1) << (v & 63);
+            vector<uint16_t>().swap(array);
+        }
+
+        void recount() {
+            card = 0;
+            for (uint64_t w : bits)
+                card += __builtin_popcountll(w);
+        }
+
+        // pick the smaller form for the current cardinality
+        void normalize() {
+            if (dense() && card <= ArrayMax) {
+                for (size_t i = 0; i < Words; i++)
+                    for (uint64_t w = bits[i]; w; w &= w - 1)
+                        array.push_back(i * 64 + __builtin_ctzll(w));
+                vector<uint64_t>().swap(bits);
+            } else if (!dense() && card > ArrayMax) {
+                makeDense();
+            }
+        }
+    };
+
+    vector<uint16_t> keys;  // high halves, sorted, parallel to containers
+    vector<Container> containers;
+
+    static Container intersect(const Container& a, const Container& b) {
+        Container out;
+        if (a.dense() && b.dense()) {
+            out.bits.resize(Words);
+            for (size_t i = 0; i < Words; i++)
+                out.bits[i] = a.bits[i] & b.bits[i];
+            out.recount();
+        } else if (a.dense() || b.dense()) {
+            const Container& sparse = a.dense() ? b : a;
+            const Container& full = a.dense() ? a : b;
+            for (uint16_t v : sparse.array)
+                if (full.contains(v))
+                    out.array.push_back(v);
+            out.card = out.array.size();
+        } else {
+            set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), back_inserter(out.array));
+            out.card = out.array.size();
+        }
+        out.normalize();
+        return out;
+    }
+
+    static Container unite(const Container& a, const Container& b) {
+        Container out;
+        if (a.dense() || b.dense()) {
+            const Container& full = a.dense() ? a : b;
+            const Container& other = a.dense() ? b : a;
+            out.bits = full.bits;
+            if (other.dense()) {
+                for (size_t i = 0; i < Words; i++)
+                    out.bits[i] |= other.bits[i];
+            } else {
+                for (uint16_t v : other.array)
+                    out.bits[v >> 6] |= uint64_t(1) << (v & 63);
+            }
+            out.recount();
+        } else {
+            set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), back_inserter(out.array));
+            out.card = out.array.size();
+        }
+        out.normalize();
+        return out;
+    }
+
+    static Container subtract(const Container& a, const Container& b) {
+        Container out;
+        if (a.dense()) {
+            out.bits = a.bits;
+            if (b.dense()) {
+                for (size_t i = 0; i < Words; i++)
+                    out.bits[i] &= ~b.bits[i];
+            } else {
+                for (uint16_t v : b.array)
+                    out.bits[v >> 6] &= ~(uint64_t(1) << (v & 63));
+            }
+            out.recount();
+        } else {
+            for (uint16_t v : a.array)
+                if (!b.contains(v))
+                    out.array.push_back(v);
+            out.card = out.array.size();
+        }
+        out.normalize();
+        return out;
+    }
+
+    // walks both key lists in step; onlyA/onlyB say whether unmatched blocks survive
+    template <typename Op>
+    static RoaringBitmap combine(const RoaringBitmap& a, const RoaringBitmap& b, Op op, bool onlyA, bool onlyB) {
+        RoaringBitmap out;
+        size_t i = 0, j = 0;
+        auto emit = [&](uint16_t key, Container c) {
+            if (c.card == 0)
+                return;
+            out.keys.push_back(key);
+            out.containers.push_back(move(c));
+        };
+        while (i < a.keys.size() || j < b.keys.size()) {
+            if (j == b.keys.size() || (i < a.keys.size() && a.keys[i] < b.keys[j])) {
+                if (onlyA)
+                    emit(a.keys[i], a.containers[i]);
+                i++;
+            } else if (i == a.keys.size() || b.keys[j] < a.keys[i]) {
+                if (onlyB)
+                    emit(b.keys[j], b.containers[j]);
+                j++;
+            } else {
+                emit(a.keys[i], op(a.containers[i], b.containers[j]));
+                i++, j++;
+            }
+        }
+        return out;
+    }
+
+public:
+    void add(uint32_t x) {
+        uint16_t key = x >> 16, low = x & 0xFFFF;
+        size_t pos = lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+        if (pos == keys.size() || keys[pos] != key) {
+            keys.insert(keys.begin() + pos, key);
+            containers.insert(containers.begin() + pos, Container());
+        }
+        Container& c = containers[pos];
+        if (c.contains(low))
+            return;
+        if (c.dense()) {
+            c.bits[low >> 6] |= uint64_t(1) << (low & 63);
+        } else {
+            c.array.insert(lower_bound(c.array.begin(), c.array.end(), low), low);
+        }
+        c.card++;
+        c.normalize();
+    }
+
+    void remove(uint32_t x) {
+        uint16_t key = x >> 16, low = x & 0xFFFF;
+        size_t pos = lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+        if (pos == keys.size() || keys[pos] != key)
+            return;
+        Container& c = containers[pos];
+        if (!c.contains(low))
+            return;
+        if (c.dense())
+            c.bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+        else
+            c.array.erase(lower_bound(c.array.begin(), c.array.end(), low));
+        if (--c.card == 0) {
+            keys.erase(keys.begin() + pos);
+            containers.erase(containers.begin() + pos);
+        } else {
+            c.normalize();
+        }
+    }
+
+    size_t cardinality() const {
+        size_t total = 0;
+        for (auto& c : containers)
+            total += c.card;
+        return total;
+    }
+
+    static RoaringBitmap andOf(const RoaringBitmap& a, const RoaringBitmap& b) {
+        return combine(a, b, intersect, false, false);
+    }
+
+    static RoaringBitmap orOf(const RoaringBitmap& a, const RoaringBitmap& b) {
+        return combine(a, b, unite, true, true);
+    }
+
+    static RoaringBitmap andNotOf(const RoaringBitmap& a, const RoaringBitmap& b) {
+        return combine(a, b, subtract, true, false);
+    }
+
+    // ascending ids
+    template <typename F>
+    void forEach(F&& f) const {
+        for (size_t k = 0; k < keys.size(); k++) {
+            uint32_t high = uint32_t(keys[k]) << 16;
+            const Container& c = containers[k];
+            if (!c.dense()) {
+                for (uint16_t v : c.array)
+                    f(high | v);
+                continue;
+            }
+            for (size_t i = 0; i < Words; i++)
+                for (uint64_t w = c.bits[i]; w; w &= w - 1)
+                    f(high | uint32_t(i * 64 + __builtin_ctzll(w)));
+        }
+    }
+};
+
+// Borrowed views, nothing is copied. They stay valid until that task is deleted or archived.
+struct TaskPage {
+    vector<const Task*> tasks;
+    optional<TaskCursor> next;  // empty on the last page
+};
+
+// One user's tasks plus a tag -> tasks index in the same (dueDate, taskId) order,
+// so a tag query walks only the tasks carrying that tag. Finished tasks leave the
+// ordered structures, so listing never has to skip over them.
+struct UserTasks {
+    set<Task*, CompareTask> active;
+    unordered_set<Task*> completed;                     // kept until deleted or archived
+    unordered_map<int, Task*> byId;                     // active and completed
+    unordered_map<int, set<Task*, CompareTask>> byTag;  // active only
+    RoaringBitmap activeIds;                            // universe for NOT-only tag queries
+    unordered_map<int, RoaringBitmap> tagIds;           // tag id -> active task ids, for AND/OR/NOT
+};
+
+// Columnar input for bulkImport, row i is (userIds[i], descriptions[i], dueDates[i], tags[i])
+struct TaskBatch {
+    vector<int> userIds;
+    vector<string> descriptions;
+    vector<int> dueDates;
+    vector<vector<string>> tags;
+
+    size_t size() const { return userIds.size(); }
+};
+
+// Everything for the users that hash to one shard. Not thread safe on its own,
+// TodoList holds the shard's lock around every call.
+class TodoShard {
+private:
+    TagTable tagTable;
+    SlabPool<Task> pool;
+    unordered_map<int, UserTasks> tasks;
+    DueIndex due;
+
+    // O(log n + limit): seek past the cursor, then read one page
+    static TaskPage readPage(const set<Task*, CompareTask>& ordered, optional<TaskCursor> after, size_t limit) {
+        TaskPage page;
+        auto it = after ? ordered.upper_bound(*after) : ordered.begin();
+        for (; it != ordered.end() && page.tasks.size() < limit; ++it)
+            page.tasks.push_back(*it);
+        if (it != ordered.end() && !page.tasks.empty())
+            page.next = TaskCursor{page.tasks.back()->dueDate, page.tasks.back()->taskId};
+        return page;
+    }
+
+    void unindexActive(UserTasks& user, Task* task) {
+        user.active.erase(task);
+        user.activeIds.remove(task->taskId);
+        due.remove(task);
+        for (int tag : task->tags) {
+            auto it = user.byTag.find(tag);
+            it->second.erase(task);
+            if (it->second.empty())
+                user.byTag.erase(it);
+            auto bits = user.tagIds.find(tag);
+            bits->second.remove(task->taskId);
+            if (bits->second.cardinality() == 0)
+                user.tagIds.erase(bits);
+        }
+    }
+
+public:
+    explicit TodoShard(int dueBucketWidth) : due(dueBucketWidth) {}
+
+    ~TodoShard() {
+        for (auto& [_, user] : tasks)
+            for (auto& [_, task] : user.byId)
+                pool.destroy(task);
+    }
+
+    TodoShard(const TodoShard&) = delete;
+    TodoShard& operator=(const TodoShard&) = delete;
+
+    // taskId comes from TodoList, which keeps ids unique across shards
+    int addTask(int taskId, int userId, string taskDescription, int dueDate, vector<string> tags) {
+        vector<int> tagIds;
+        for (auto& tag : tags)
+            tagIds.push_back(tagTable.intern(tag));
+        sort(tagIds.begin(), tagIds.end());
+        tagIds.erase(unique(tagIds.begin(), tagIds.end()), tagIds.end());
+
+        Task* task = pool.create(taskId, userId, move(taskDescription), dueDate, tagIds);
+        UserTasks& user = tasks[userId];
+        user.active.insert(task);
+        due.add(task);
+        user.byId[task->taskId] = task;
+        user.activeIds.add(task->taskId);
+        for (int tag : task->tags) {
+            user.byTag[tag].insert(task);
+            user.tagIds[tag].add(task->taskId);
+        }
         return task->taskId;
     }
 
@@ -44,34 +561,1164 @@ public:
         if (tasks.find(userId) == tasks.end())
             return ans;
 
-        for (auto task : tasks[userId]) {
-            if (!task->finish)
-                ans.push_back(task->taskName);
-        }
+        for (auto task : tasks[userId].active)
+            ans.push_back(task->taskName);
         return ans;
     }
 
+    // O(log n + results): reads the user's index for that tag only
     vector<string> getTasksForTag(int userId, string tag) {
         vector<string> ans;
-        if (tasks.find(userId) == tasks.end())
+        auto user = tasks.find(userId);
+        int tagId = tagTable.find(tag);
+        if (user == tasks.end() || tagId < 0)
+            return ans;
+
+        auto it = user->second.byTag.find(tagId);
+        if (it == user->second.byTag.end())
             return ans;
+        for (auto task : it->second)
+            ans.push_back(task->taskName);
+        return ans;
+    }
+
+    TaskPage listTasks(int userId, optional<TaskCursor> after, size_t limit) {
+        auto user = tasks.find(userId);
+        if (user == tasks.end())
+            return {};
+        return readPage(user->second.active, after, limit);
+    }
+
+    TaskPage listTasksForTag(int userId, const string& tag, optional<TaskCursor> after, size_t limit) {
+        auto user = tasks.find(userId);
+        int tagId = tagTable.find(tag);
+        if (user == tasks.end() || tagId < 0)
+            return {};
+        auto it = user->second.byTag.find(tagId);
+        if (it == user->second.byTag.end())
+            return {};
+        return readPage(it->second, after, limit);
+    }
+
+    // open tasks having every tag in allOf, at least one of anyOf (when given) and none of noneOf,
+    // by (dueDate, taskId). e.g. work AND urgent AND NOT blocked = ({"work", "urgent"}, {}, {"blocked"})
+    vector<const Task*> queryTags(int userId, const vector<string>& allOf, const vector<string>& anyOf,
+                                  const vector<string>& noneOf) {
+        vector<const Task*> ans;
+        auto found = tasks.find(userId);
+        if (found == tasks.end())
+            return ans;
+        UserTasks& user = found->second;
+        static const RoaringBitmap empty;
+        auto bitsFor = [&](const string& tag) -> const RoaringBitmap& {
+            int tagId = tagTable.find(tag);
+            auto it = tagId < 0 ? user.tagIds.end() : user.tagIds.find(tagId);
+            return it == user.tagIds.end() ? empty : it->second;
+        };
+
+        RoaringBitmap result = user.activeIds;
+        for (auto& tag : allOf)
+            result = RoaringBitmap::andOf(result, bitsFor(tag));
+        if (!anyOf.empty()) {
+            RoaringBitmap either;
+            for (auto& tag : anyOf)
+                either = RoaringBitmap::orOf(either, bitsFor(tag));
+            result = RoaringBitmap::andOf(result, either);
+        }
+        for (auto& tag : noneOf)
+            result = RoaringBitmap::andNotOf(result, bitsFor(tag));
+
+        ans.reserve(result.cardinality());
+        result.forEach([&](uint32_t id) { ans.push_back(user.byId[id]); });
+        sort(ans.begin(), ans.end(), CompareTask());
+        return ans;
+    }
 
-        for (auto task : tasks[userId]) {
-            if (!task->finish && task->tags.count(tag))
-                ans.push_back(task->taskName);
+    // same query answered by walking every open task, kept as the baseline for benchQueryTags
+    vector<const Task*> queryTagsByScan(int userId, const vector<string>& allOf, const vector<string>& anyOf,
+                                        const vector<string>& noneOf) {
+        vector<const Task*> ans;
+        auto found = tasks.find(userId);
+        if (found == tasks.end())
+            return ans;
+        auto has = [&](const Task* task, const string& tag) {
+            int tagId = tagTable.find(tag);
+            return find(task->tags.begin(), task->tags.end(), tagId) != task->tags.end();
+        };
+        for (const Task* task : found->second.active) {
+            bool keep = all_of(allOf.begin(), allOf.end(), [&](auto& t) { return has(task, t); }) &&
+                        (anyOf.empty() || any_of(anyOf.begin(), anyOf.end(), [&](auto& t) { return has(task, t); })) &&
+                        none_of(noneOf.begin(), noneOf.end(), [&](auto& t) { return has(task, t); });
+            if (keep)
+                ans.push_back(task);
         }
         return ans;
     }
 
+    // open tasks of this shard's users due in [from, to]
+    vector<const Task*> getTasksDueBetween(int from, int to) const {
+        return due.range(from, to);
+    }
+
+    // open tasks of this shard's users that went overdue since the last call
+    vector<const Task*> sweepOverdue(int now) {
+        return due.sweep(now);
+    }
+
+    // Loads rows of batch (row r gets id ids[r]) in one go. A first pass walks the rows in
+    // batch order, interning tags and moving descriptions into arrays local to this shard, so
+    // the main pass, sorted by (user, dueDate, id), reads cache-sized arrays instead of jumping
+    // around the whole batch. Every set insert then lands at the end of its set with a hint,
+    // and id bitmaps are filled in ascending order.
+    void bulkLoad(TaskBatch& batch, const vector<uint32_t>& rows, const vector<int>& ids) {
+        vector<string> names(rows.size());
+        vector<uint32_t> tagStart(rows.size() + 1);
+        vector<int> tagPool;
+        for (size_t k = 0; k < rows.size(); k++) {
+            uint32_t row = rows[k];
+            names[k] = move(batch.descriptions[row]);
+            tagStart[k] = tagPool.size();
+            for (auto& tag : batch.tags[row])
+                tagPool.push_back(tagTable.intern(tag));
+            auto first = tagPool.begin() + tagStart[k];
+            sort(first, tagPool.end());
+            tagPool.erase(unique(first, tagPool.end()), tagPool.end());
+        }
+        tagStart[rows.size()] = tagPool.size();
+
+        // sort keys copied next to each other instead of chasing three columns per comparison
+        vector<tuple<int, int, uint32_t>> order;
+        order.reserve(rows.size());
+        for (uint32_t k = 0; k < rows.size(); k++)
+            order.emplace_back(batch.userIds[rows[k]], batch.dueDates[rows[k]], k);
+        sort(order.begin(), order.end());
+
+        vector<int> tagIds;
+        for (size_t i = 0; i < order.size();) {
+            int userId = get<0>(order[i]);
+            size_t end = i;
+            while (end < order.size() && get<0>(order[end]) == userId)
+                end++;
+            UserTasks& user = tasks[userId];
+            user.byId.reserve(user.byId.size() + end - i);
+            vector<Task*> added;
+            for (; i < end; i++) {
+                uint32_t k = get<2>(order[i]);
+                tagIds.assign(tagPool.begin() + tagStart[k], tagPool.begin() + tagStart[k + 1]);
+                Task* task = pool.create(ids[rows[k]], userId, move(names[k]), get<1>(order[i]), tagIds);
+                user.active.insert(user.active.end(), task);
+                user.byId[task->taskId] = task;
+                due.add(task);
+                for (int tag : task->tags) {
+                    auto& tagged = user.byTag[tag];
+                    tagged.insert(tagged.end(), task);
+                }
+                added.push_back(task);
+            }
+
+            sort(added.begin(), added.end(), [](Task* a, Task* b) { return a->taskId < b->taskId; });
+            for (Task* task : added) {
+                user.activeIds.add(task->taskId);
+                for (int tag : task->tags)
+                    user.tagIds[tag].add(task->taskId);
+            }
+        }
+    }
+
+    // O(1) lookup, O(log n) per ordered structure the task leaves
     void completeTask(int userId, int taskId) {
         if (tasks.find(userId) == tasks.end())
             return;
 
-        for (auto task : tasks[userId]) {
-            if (task->taskId == taskId) {
-                task->finish = true;
+        UserTasks& user = tasks[userId];
+        auto found = user.byId.find(taskId);
+        if (found == user.byId.end() || found->second->finish)
+            return;
+
+        Task* task = found->second;
+        task->finish = true;
+        unindexActive(user, task);
+        user.completed.insert(task);
+    }
+
+    // removes the task whether open or finished and gives its slot back to the pool
+    bool deleteTask(int userId, int taskId) {
+        auto it = tasks.find(userId);
+        if (it == tasks.end())
+            return false;
+
+        UserTasks& user = it->second;
+        auto found = user.byId.find(taskId);
+        if (found == user.byId.end())
+            return false;
+
+        Task* task = found->second;
+        if (task->finish)
+            user.completed.erase(task);
+        else
+            unindexActive(user, task);
+        user.byId.erase(found);
+        pool.destroy(task);
+        return true;
+    }
+
+    // frees every finished task of the user, returns how many went
+    size_t archiveCompleted(int userId) {
+        auto it = tasks.find(userId);
+        if (it == tasks.end())
+            return 0;
+
+        UserTasks& user = it->second;
+        size_t archived = user.completed.size();
+        for (Task* task : user.completed) {
+            user.byId.erase(task->taskId);
+            pool.destroy(task);
+        }
+        user.completed.clear();
+        return archived;
+    }
+
+    size_t liveTasks() const {
+        return pool.live();
+    }
+
+    // every stored task (open and finished) with its tag names, for snapshots
+    template <typename F>
+    void forEachTask(F&& fn) const {
+        vector<string> names;
+        for (auto& [_, user] : tasks)
+            for (auto& [_, task] : user.byId) {
+                names.clear();
+                for (int tag : task->tags)
+                    names.push_back(tagTable.name(tag));
+                fn(*task, names);
+            }
+    }
+
+    size_t poolBytes() const {
+        return pool.reservedBytes();
+    }
+};
+
+// ----------- Persistence: append-only journal + snapshot -----------
+// A directory holds "snapshot" (live tasks as of some point) and journal.<seq> segments with
+// every add/complete/delete/archive since. Each record is framed as
+// varint(length) payload fnv32(payload), so a torn tail after a crash is detected and dropped.
+// Tag strings are written once per file and referred to by number after that.
+
+enum RecordType : uint8_t { TagDef = 'T', AddRec = 'A', CompleteRec = 'C', DeleteRec = 'D', ArchiveRec = 'R' };
+
+static void putVarint(string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(char(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(char(v));
+}
+
+static void putSigned(string& out, int64_t v) {  // zigzag, small negatives stay short
+    putVarint(out, (uint64_t(v) << 1) ^ uint64_t(v >> 63));
+}
+
+static void putString(string& out, const string& s) {
+    putVarint(out, s.size());
+    out += s;
+}
+
+static uint32_t fnv32(const char* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ uint8_t(p[i])) * 16777619u;
+    return h;
+}
+
+class RecordEncoder {
+private:
+    string out;
+    string payload;
+    unordered_map<string, uint32_t> tagNos;  // this file's tag dictionary
+
+    void frame() {
+        putVarint(out, payload.size());
+        out += payload;
+        uint32_t sum = fnv32(payload.data(), payload.size());
+        out.append(reinterpret_cast<const char*>(&sum), sizeof(sum));
+        payload.clear();
+    }
+
+    uint32_t tagNo(const string& tag) {
+        auto it = tagNos.find(tag);
+        if (it != tagNos.end())
+            return it->second;
+        uint32_t no = tagNos.size();
+        tagNos.emplace(tag, no);
+        payload.push_back(TagDef);
+        putVarint(payload, no);
+        putString(payload, tag);
+        frame();
+        return no;
+    }
+
+public:
+    template <typename Tags>
+    void add(int taskId, int userId, int dueDate, const string& name, const Tags& tags) {
+        vector<uint32_t> nos;
+        for (auto& tag : tags)
+            nos.push_back(tagNo(tag));
+        payload.push_back(AddRec);
+        putVarint(payload, taskId);
+        putSigned(payload, userId);
+        putSigned(payload, dueDate);
+        putString(payload, name);
+        putVarint(payload, nos.size());
+        for (uint32_t no : nos)
+            putVarint(payload, no);
+        frame();
+    }
+
+    void userEvent(RecordType type, int userId, int taskId = 0) {
+        payload.push_back(type);
+        putSigned(payload, userId);
+        if (type != ArchiveRec)
+            putVarint(payload, taskId);
+        frame();
+    }
+
+    string& bytes() { return out; }
+
+    void resetDictionary() { tagNos.clear(); }
+};
+
+// One decoded record; tags already resolved through the file's dictionary
+struct JournalRecord {
+    RecordType type;
+    int taskId = 0, userId = 0, dueDate = 0;
+    string name;
+    vector<string> tags;
+};
+
+// Calls apply for every intact record of a file, stops at the first torn or corrupt one.
+// Returns the bytes consumed.
+template <typename F>
+size_t replayFile(const string& data, size_t pos, F&& apply) {
+    vector<string> dictionary;
+    auto varint = [&](const char*& p, const char* end) {
+        uint64_t v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t b = *p++;
+            v |= uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        throw runtime_error("Truncated varint");
+    };
+    auto zigzag = [&](const char*& p, const char* end) {
+        uint64_t v = varint(p, end);
+        return int64_t(v >> 1) ^ -int64_t(v & 1);
+    };
+
+    while (pos < data.size()) {
+        const char* p = data.data() + pos;
+        const char* end = data.data() + data.size();
+        try {
+            uint64_t len = varint(p, end);
+            if (uint64_t(end - p) < len + 4)
+                break;
+            uint32_t sum;
+            memcpy(&sum, p + len, 4);
+            if (sum != fnv32(p, len))
                 break;
+            const char* q = p;
+            const char* qend = p + len;
+            JournalRecord rec;
+            rec.type = RecordType(*q++);
+            if (rec.type == TagDef) {
+                uint64_t no = varint(q, qend);
+                uint64_t n = varint(q, qend);
+                if (no != dictionary.size() || uint64_t(qend - q) < n)
+                    break;
+                dictionary.emplace_back(q, n);
+            } else if (rec.type == AddRec) {
+                rec.taskId = varint(q, qend);
+                rec.userId = zigzag(q, qend);
+                rec.dueDate = zigzag(q, qend);
+                uint64_t n = varint(q, qend);
+                if (uint64_t(qend - q) < n)
+                    break;
+                rec.name.assign(q, n);
+                q += n;
+                for (uint64_t t = varint(q, qend); t > 0; t--) {
+                    uint64_t no = varint(q, qend);
+                    if (no >= dictionary.size())
+                        throw runtime_error("Unknown tag");
+                    rec.tags.push_back(dictionary[no]);
+                }
+                apply(rec);
+            } else {
+                rec.userId = zigzag(q, qend);
+                if (rec.type != ArchiveRec)
+                    rec.taskId = varint(q, qend);
+                apply(rec);
+            }
+            pos = (p - data.data()) + len + 4;
+        } catch (const runtime_error&) {
+            break;
+        }
+    }
+    return pos;
+}
+
+struct JournalOptions {
+    chrono::milliseconds syncInterval{5};  // group commit window: records wait at most this long for fsync
+    size_t compactAfterBytes = 64 << 20;   // segment size that triggers a background snapshot
+};
+
+class Journal {
+private:
+    filesystem::path dir;
+    int fd = -1;
+    uint64_t fdSeq;                  // segment fd writes to, behind seq while a sealed tail waits
+    uint64_t seq;                    // segment new records belong to
+    atomic<size_t> segmentBytes{0};  // written to fd so far
+    RecordEncoder pending;           // logged, not yet taken by a flush
+    vector<string> sealedTails;      // unwritten ends of sealed segments, oldest first
+    string outgoing;                 // what the running flush writes, reused between flushes
+    mutex m;    // pending, sealedTails and seq; held only to append a record or swap buffers
+    mutex ioM;  // one flush at a time so bytes reach the files in log order; held across fdatasync
+    string failure;  // under ioM; set by the first failed flush, after which nothing is durable
+
+    // fdatasync/fsync/close results matter: a failed flush may already have dropped the dirty
+    // pages, so retrying it would report records durable that never reached the disk
+    static void check(int rc, const string& what) {
+        if (rc < 0)
+            throw runtime_error(what + " failed: " + strerror(errno));
+    }
+
+    static void writeAll(int fd, const string& bytes) {
+        for (size_t off = 0; off < bytes.size();) {
+            ssize_t n = ::write(fd, bytes.data() + off, bytes.size() - off);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw runtime_error("Journal write failed");
+            }
+            off += n;
+        }
+    }
+
+    void openSegment() {
+        filesystem::path path = dir / ("journal." + to_string(fdSeq));
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (fd < 0)
+            throw runtime_error("Cannot open " + path.string());
+        writeAll(fd, "TDJ1");
+        segmentBytes = 4;
+    }
+
+public:
+    Journal(filesystem::path dir, uint64_t seq) : dir(move(dir)), fdSeq(seq), seq(seq) {
+        openSegment();
+    }
+
+    ~Journal() {
+        try {
+            sync();
+        } catch (const exception&) {
+            // already reported to whoever called sync(); nothing more a destructor can do
+        }
+        ::close(fd);
+    }
+
+    template <typename Tags>
+    void logAdd(int taskId, int userId, int dueDate, const string& name, const Tags& tags) {
+        lock_guard<mutex> lock(m);
+        pending.add(taskId, userId, dueDate, name, tags);
+    }
+
+    void logUserEvent(RecordType type, int userId, int taskId = 0) {
+        lock_guard<mutex> lock(m);
+        pending.userEvent(type, userId, taskId);
+    }
+
+    void logBatch(const TaskBatch& batch, const vector<uint32_t>& rows, const vector<int>& ids) {
+        lock_guard<mutex> lock(m);
+        for (uint32_t row : rows)
+            pending.add(ids[row], batch.userIds[row], batch.dueDates[row], batch.descriptions[row],
+                        batch.tags[row]);
+    }
+
+    // Write and fdatasync everything logged so far. The buffers are swapped out under m and the
+    // I/O runs after releasing it, so logging threads (and the shard locks they hold) never
+    // wait for the disk. Throws if the bytes could not be made durable; once that has happened
+    // every later call throws the same error, since records logged before it may be lost.
+    void sync() {
+        lock_guard<mutex> io(ioM);
+        if (!failure.empty())
+            throw runtime_error(failure);
+        vector<string> tails;
+        {
+            lock_guard<mutex> lock(m);
+            tails.swap(sealedTails);
+            outgoing.swap(pending.bytes());
+        }
+        try {
+            for (auto& tail : tails) {
+                writeAll(fd, tail);
+                check(::fdatasync(fd), "Journal fdatasync");
+                int closing = fd;
+                fd = -1;
+                check(::close(closing), "Journal close");
+                fdSeq++;
+                openSegment();
             }
+            if (outgoing.empty())
+                return;
+            writeAll(fd, outgoing);
+            check(::fdatasync(fd), "Journal fdatasync");
+        } catch (const exception& e) {
+            failure = e.what();
+            throw;
+        }
+        segmentBytes += outgoing.size();
+        outgoing.clear();
+    }
+
+    size_t bytesInSegment() {
+        lock_guard<mutex> lock(m);
+        return (sealedTails.empty() ? segmentBytes.load() : 4) + pending.bytes().size();
+    }
+
+    // Cuts the log: everything logged so far belongs to segments up to the returned seq, anything
+    // after to the next one. No I/O, the next sync() writes the tail and switches files.
+    uint64_t seal() {
+        lock_guard<mutex> lock(m);
+        sealedTails.push_back(move(pending.bytes()));
+        pending.bytes().clear();
+        pending.resetDictionary();  // the tag dictionary is per file
+        return seq++;
+    }
+
+    // snapshot covering every segment up to coveredSeq: written aside, fsynced, renamed into
+    // place, and only then are the covered segments removed
+    void installSnapshot(const string& records, uint64_t coveredSeq, int nextId) {
+        string header = "TDS1";
+        putVarint(header, coveredSeq);
+        putVarint(header, nextId);
+        filesystem::path tmp = dir / "snapshot.tmp";
+        int out = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out < 0)
+            throw runtime_error("Cannot write snapshot");
+        try {
+            writeAll(out, header);
+            writeAll(out, records);
+            check(::fsync(out), "Snapshot fsync");
+        } catch (const exception&) {
+            ::close(out);
+            throw;
         }
+        check(::close(out), "Snapshot close");
+        filesystem::rename(tmp, dir / "snapshot");
+        // the rename has to be durable before the segments it replaces can go
+        int dirFd = ::open(dir.c_str(), O_RDONLY);
+        check(dirFd, "Journal directory open");
+        int synced = ::fsync(dirFd);
+        ::close(dirFd);
+        check(synced, "Journal directory fsync");
+        for (auto& entry : filesystem::directory_iterator(dir)) {
+            string name = entry.path().filename().string();
+            if (name.rfind("journal.", 0) == 0 && stoull(name.substr(8)) <= coveredSeq)
+                filesystem::remove(entry.path());
+        }
+    }
+};
+
+static string readWholeFile(const filesystem::path& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+// Users are spread over shards by userId, each shard behind its own mutex, so threads working
+// on different users rarely meet. Task ids come from one atomic counter and stay globally unique.
+// Views returned by queries (const Task*, TaskPage) may be read while other threads work on
+// other users; deleting or archiving that user's tasks still invalidates them.
+class TodoList {
+private:
+    struct Shard {
+        mutex m;
+        TodoShard todo;
+        explicit Shard(int dueBucketWidth) : todo(dueBucketWidth) {}
+    };
+
+    atomic<int> idCounter{1};
+    vector<unique_ptr<Shard>> shards;
+
+    unique_ptr<Journal> journal;  // null = in memory only
+    JournalOptions journalOptions;
+    thread maintenance;           // group commit and background compaction
+    mutex maintenanceM;
+    condition_variable maintenanceWake;
+    bool stopping = false;
+    mutex compactM;
+
+    void maintain() {
+        unique_lock<mutex> lock(maintenanceM);
+        while (!stopping) {
+            maintenanceWake.wait_for(lock, journalOptions.syncInterval);
+            lock.unlock();
+            try {
+                journal->sync();
+                if (journal->bytesInSegment() > journalOptions.compactAfterBytes)
+                    compact();
+            } catch (const exception&) {
+                return;  // the journal keeps the error, sync() rethrows it to callers
+            }
+            lock.lock();
+        }
+    }
+
+    // Rows are bucketed by shard, then every shard sorts and loads its rows on its own thread
+    void loadBatch(TaskBatch& batch, const vector<int>& ids, bool log) {
+        unordered_map<Shard*, size_t> slot;
+        vector<Shard*> touched;
+        vector<vector<uint32_t>> rows;
+        for (uint32_t r = 0; r < batch.size(); r++) {
+            Shard* shard = &shardFor(batch.userIds[r]);
+            auto [it, fresh] = slot.emplace(shard, touched.size());
+            if (fresh) {
+                touched.push_back(shard);
+                rows.emplace_back();
+            }
+            rows[it->second].push_back(r);
+        }
+
+        atomic<size_t> next{0};
+        auto worker = [&] {
+            for (size_t i; (i = next.fetch_add(1)) < touched.size();) {
+                lock_guard<mutex> lock(touched[i]->m);
+                if (journal && log)
+                    journal->logBatch(batch, rows[i], ids);
+                touched[i]->todo.bulkLoad(batch, rows[i], ids);
+            }
+        };
+        size_t threads = min<size_t>(touched.size(), max(1u, thread::hardware_concurrency()));
+        vector<thread> pool;
+        for (size_t t = 1; t < threads; t++)
+            pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool)
+            t.join();
+    }
+
+    // applies one recovered record, no logging: the journal is not open yet
+    void replay(const JournalRecord& rec) {
+        Shard& shard = shardFor(rec.userId);
+        switch (rec.type) {
+        case AddRec:
+            shard.todo.addTask(rec.taskId, rec.userId, rec.name, rec.dueDate, rec.tags);
+            if (rec.taskId >= idCounter)
+                idCounter = rec.taskId + 1;
+            break;
+        case CompleteRec:
+            shard.todo.completeTask(rec.userId, rec.taskId);
+            break;
+        case DeleteRec:
+            shard.todo.deleteTask(rec.userId, rec.taskId);
+            break;
+        case ArchiveRec:
+            shard.todo.archiveCompleted(rec.userId);
+            break;
+        default:
+            break;
+        }
+    }
+
+    Shard& shardFor(int userId) {
+        uint32_t h = uint32_t(userId) * 0x9E3779B1u;  // spread consecutive ids over shards
+        return *shards[h % shards.size()];
+    }
+
+    // runs fn on one user's shard under its lock
+    template <typename F>
+    auto withUser(int userId, F&& fn) {
+        Shard& shard = shardFor(userId);
+        lock_guard<mutex> lock(shard.m);
+        return fn(shard.todo);
+    }
+
+    // runs fn on every shard in turn and merges the per-shard results by (dueDate, taskId)
+    template <typename F>
+    vector<const Task*> acrossShards(F&& fn) {
+        vector<const Task*> ans;
+        for (auto& shard : shards) {
+            lock_guard<mutex> lock(shard->m);
+            auto part = fn(shard->todo);
+            ans.insert(ans.end(), part.begin(), part.end());
+        }
+        sort(ans.begin(), ans.end(), CompareTask());
+        return ans;
+    }
+
+public:
+    // dueDate values per bucket of the due-date index
+    explicit TodoList(int dueBucketWidth = 16, size_t shardCount = 64) {
+        if (shardCount == 0)
+            throw invalid_argument("Need at least one shard");
+        for (size_t i = 0; i < shardCount; i++)
+            shards.push_back(make_unique<Shard>(dueBucketWidth));
     }
-};
\ No newline at end of file
+
+    ~TodoList() {
+        if (maintenance.joinable()) {
+            {
+                lock_guard<mutex> lock(maintenanceM);
+                stopping = true;
+            }
+            maintenanceWake.notify_one();
+            maintenance.join();
+        }
+    }
+
+    TodoList(const TodoList&) = delete;
+    TodoList& operator=(const TodoList&) = delete;
+
+    // Loads dir's snapshot and newer journal segments into this list, which must be empty, then
+    // logs every change from here on. Changes are durable once the next group commit has run or
+    // after sync() returns; a failed flush stops the group commit and makes sync() throw from then
+    // on. A snapshot is only ever renamed into place whole, so a damaged one throws
+    // instead of loading part of it.
+    void openJournal(const string& dirPath, JournalOptions options = {}) {
+        if (journal)
+            throw runtime_error("Journal already open");
+        if (liveTasks() != 0)
+            throw runtime_error("Journal can only be opened on an empty list");
+        filesystem::path dir(dirPath);
+        filesystem::create_directories(dir);
+
+        uint64_t covered = 0, lastSeq = 0;
+        bool hasSnapshot = filesystem::exists(dir / "snapshot");
+        if (hasSnapshot) {
+            string data = readWholeFile(dir / "snapshot");
+            if (data.compare(0, 4, "TDS1") != 0)
+                throw runtime_error("Bad snapshot header");
+            size_t pos = 4;
+            auto varint = [&] {
+                uint64_t v = 0;
+                for (int shift = 0; pos < data.size() && shift < 64; shift += 7) {
+                    uint8_t b = data[pos++];
+                    v |= uint64_t(b & 0x7F) << shift;
+                    if (!(b & 0x80))
+                        return v;
+                }
+                throw runtime_error("Corrupt snapshot header");
+            };
+            covered = lastSeq = varint();
+            idCounter = max<int>(idCounter, varint());
+
+            // a snapshot holds only adds and completes; load the adds the bulk way, completes after
+            TaskBatch batch;
+            vector<int> ids;
+            vector<JournalRecord> completes;
+            size_t end = replayFile(data, pos, [&](JournalRecord& rec) {
+                if (rec.type != AddRec) {
+                    completes.push_back(move(rec));
+                    return;
+                }
+                batch.userIds.push_back(rec.userId);
+                batch.descriptions.push_back(move(rec.name));
+                batch.dueDates.push_back(rec.dueDate);
+                batch.tags.push_back(move(rec.tags));
+                ids.push_back(rec.taskId);
+            });
+            if (end != data.size())
+                throw runtime_error("Corrupt snapshot at byte " + to_string(end));
+            loadBatch(batch, ids, false);
+            for (auto& rec : completes)
+                replay(rec);
+        }
+
+        vector<uint64_t> segments;
+        for (auto& entry : filesystem::directory_iterator(dir)) {
+            string name = entry.path().filename().string();
+            if (name.rfind("journal.", 0) == 0)
+                segments.push_back(stoull(name.substr(8)));
+        }
+        sort(segments.begin(), segments.end());
+        for (uint64_t seq : segments) {
+            lastSeq = max(lastSeq, seq);
+            if (hasSnapshot && seq <= covered)
+                continue;  // already folded into the snapshot
+            string data = readWholeFile(dir / ("journal." + to_string(seq)));
+            if (data.compare(0, 4, "TDJ1") == 0)
+                replayFile(data, 4, [&](const JournalRecord& rec) { replay(rec); });
+        }
+
+        journalOptions = options;
+        journal = make_unique<Journal>(dir, lastSeq + 1);
+        maintenance = thread([this] { maintain(); });
+    }
+
+    // write and fsync everything logged so far without waiting for the group commit; throws if
+    // the journal could not make it durable, then and on every later call
+    void sync() {
+        if (journal)
+            journal->sync();
+    }
+
+    // Rewrites the journal as a snapshot of live tasks only. All shards are locked just long
+    // enough to seal the current segment (no I/O); each shard is then serialized and released
+    // in turn, and anything it does afterwards lands in the new segment. Writing happens after
+    // every lock is gone.
+    void compact() {
+        if (!journal)
+            return;
+        lock_guard<mutex> one(compactM);
+        vector<unique_lock<mutex>> locks;
+        for (auto& shard : shards)
+            locks.emplace_back(shard->m);
+        uint64_t covered = journal->seal();
+        int nextId = idCounter;
+
+        RecordEncoder snapshot;
+        for (size_t i = 0; i < shards.size(); i++) {
+            shards[i]->todo.forEachTask([&](const Task& task, const vector<string>& tags) {
+                snapshot.add(task.taskId, task.userId, task.dueDate, task.taskName, tags);
+                if (task.finish)
+                    snapshot.userEvent(CompleteRec, task.userId, task.taskId);
+            });
+            locks[i].unlock();
+        }
+        journal->sync();  // finish the sealed segments before their files are replaced
+        journal->installSnapshot(snapshot.bytes(), covered, nextId);
+    }
+
+    int addTask(int userId, string taskDescription, int dueDate, vector<string> tags) {
+        int taskId = idCounter.fetch_add(1, memory_order_relaxed);
+        return withUser(userId, [&](TodoShard& s) {
+            if (journal)
+                journal->logAdd(taskId, userId, dueDate, taskDescription, tags);
+            return s.addTask(taskId, userId, move(taskDescription), dueDate, move(tags));
+        });
+    }
+
+    // Imports a whole batch and returns the assigned ids in row order
+    vector<int> bulkImport(TaskBatch batch) {
+        size_t n = batch.size();
+        if (batch.descriptions.size() != n || batch.dueDates.size() != n || batch.tags.size() != n)
+            throw invalid_argument("Batch columns differ in length");
+        vector<int> ids(n);
+        iota(ids.begin(), ids.end(), idCounter.fetch_add(int(n), memory_order_relaxed));
+        loadBatch(batch, ids, true);
+        return ids;
+    }
+
+    vector<string> getAllTasks(int userId) {
+        return withUser(userId, [&](TodoShard& s) { return s.getAllTasks(userId); });
+    }
+
+    vector<string> getTasksForTag(int userId, string tag) {
+        return withUser(userId, [&](TodoShard& s) { return s.getTasksForTag(userId, tag); });
+    }
+
+    TaskPage listTasks(int userId, optional<TaskCursor> after, size_t limit) {
+        return withUser(userId, [&](TodoShard& s) { return s.listTasks(userId, after, limit); });
+    }
+
+    TaskPage listTasksForTag(int userId, const string& tag, optional<TaskCursor> after, size_t limit) {
+        return withUser(userId, [&](TodoShard& s) { return s.listTasksForTag(userId, tag, after, limit); });
+    }
+
+    vector<const Task*> queryTags(int userId, const vector<string>& allOf, const vector<string>& anyOf,
+                                  const vector<string>& noneOf) {
+        return withUser(userId, [&](TodoShard& s) { return s.queryTags(userId, allOf, anyOf, noneOf); });
+    }
+
+    vector<const Task*> queryTagsByScan(int userId, const vector<string>& allOf, const vector<string>& anyOf,
+                                        const vector<string>& noneOf) {
+        return withUser(userId, [&](TodoShard& s) { return s.queryTagsByScan(userId, allOf, anyOf, noneOf); });
+    }
+
+    // open tasks of all users due in [from, to]
+    vector<const Task*> getTasksDueBetween(int from, int to) {
+        return acrossShards([&](TodoShard& s) { return s.getTasksDueBetween(from, to); });
+    }
+
+    // open tasks of all users that went overdue since the last call, for reminders
+    vector<const Task*> sweepOverdue(int now) {
+        return acrossShards([&](TodoShard& s) { return s.sweepOverdue(now); });
+    }
+
+    void completeTask(int userId, int taskId) {
+        withUser(userId, [&](TodoShard& s) {
+            if (journal)
+                journal->logUserEvent(CompleteRec, userId, taskId);
+            s.completeTask(userId, taskId);
+        });
+    }
+
+    bool deleteTask(int userId, int taskId) {
+        return withUser(userId, [&](TodoShard& s) {
+            if (journal)
+                journal->logUserEvent(DeleteRec, userId, taskId);
+            return s.deleteTask(userId, taskId);
+        });
+    }
+
+    size_t archiveCompleted(int userId) {
+        return withUser(userId, [&](TodoShard& s) {
+            if (journal)
+                journal->logUserEvent(ArchiveRec, userId);
+            return s.archiveCompleted(userId);
+        });
+    }
+
+    size_t liveTasks() {
+        size_t total = 0;
+        for (auto& shard : shards) {
+            lock_guard<mutex> lock(shard->m);
+            total += shard->todo.liveTasks();
+        }
+        return total;
+    }
+
+    size_t poolBytes() {
+        size_t total = 0;
+        for (auto& shard : shards) {
+            lock_guard<mutex> lock(shard->m);
+            total += shard->todo.poolBytes();
+        }
+        return total;
+    }
+};
+
+// Listing cost should depend on open tasks only, however many have been finished
+void benchCompletedTasks() {
+    const int activeCount = 100, queries = 1000;
+    for (int completedCount : {0, 10000, 100000, 1000000}) {
+        TodoList list;
+        for (int i = 0; i < completedCount; i++)
+            list.completeTask(1, list.addTask(1, "done", i, {"work"}));
+        for (int i = 0; i < activeCount; i++)
+            list.addTask(1, "open", i, {"work"});
+
+        auto start = chrono::steady_clock::now();
+        size_t seen = 0;
+        for (int q = 0; q < queries; q++) {
+            seen += list.getAllTasks(1).size();
+            seen += list.getTasksForTag(1, "work").size();
+        }
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+        cout << completedCount << " completed: " << us << " us/query (" << seen / queries << " results)" << endl;
+    }
+}
+
+size_t heapBytesInUse() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// Tags the benchmarks give task i: a quarter each work, work+urgent, home and none
+const vector<string>& benchTags(int i) {
+    static const vector<vector<string>> tagSets = {{"work"}, {"work", "urgent"}, {"home"}, {}};
+    return tagSets[i % tagSets.size()];
+}
+
+// Heap growth per task: pool slot, name, and every index entry pointing at it
+void benchTaskMemory(int taskCount) {
+    size_t before = heapBytesInUse();
+    {
+        TodoList list;
+        for (int i = 0; i < taskCount; i++)
+            list.addTask(i % 1000, "task", i % 365, benchTags(i));
+
+        size_t grown = heapBytesInUse() - before;
+        cout << taskCount << " tasks: " << double(grown) / taskCount << " bytes/task total, "
+             << double(list.poolBytes()) / taskCount << " bytes/task in the pool (sizeof(Task) = "
+             << sizeof(Task) << ")" << endl;
+
+        for (int user = 0; user < 1000; user++)
+            for (int id = user + 1; id <= taskCount; id += 2000)
+                list.completeTask(user, id);
+        size_t archived = 0;
+        for (int user = 0; user < 1000; user++)
+            archived += list.archiveCompleted(user);
+        cout << "archived " << archived << ", live " << list.liveTasks() << endl;
+    }
+}
+
+void benchQueryTags() {
+    TodoList list;
+    mt19937 rng(42);
+    const int taskCount = 1000000, queries = 20;
+    for (int i = 0; i < taskCount; i++) {
+        vector<string> tags;
+        if (rng() % 4 == 0) tags.push_back("work");
+        if (rng() % 16 == 0) tags.push_back("urgent");
+        if (rng() % 8 == 0) tags.push_back("blocked");
+        if (rng() % 2 == 0) tags.push_back("home");
+        list.addTask(1, "task", rng() % 1000, tags);
+    }
+
+    const vector<string> allOf = {"work", "urgent"}, none = {}, noneOf = {"blocked"};
+    size_t hits = 0;
+    auto start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++)
+        hits = list.queryTags(1, allOf, none, noneOf).size();
+    double bitmapMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / queries;
+
+    start = chrono::steady_clock::now();
+    size_t scanHits = 0;
+    for (int q = 0; q < queries; q++)
+        scanHits = list.queryTagsByScan(1, allOf, none, noneOf).size();
+    double scanMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / queries;
+
+    cout << "work AND urgent AND NOT blocked over " << taskCount << " tasks: bitmaps " << bitmapMs
+         << " ms, scan " << scanMs << " ms (" << hits << "/" << scanHits << " hits)" << endl;
+}
+
+// Disjoint users per thread: add, complete and list, at 1..hardware threads
+void benchConcurrentUsers() {
+    const int opsPerThread = 200000;
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        TodoList list;
+        auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&list, t] {
+                for (int i = 0; i < opsPerThread; i++) {
+                    int user = t * 1000 + i % 1000;
+                    int id = list.addTask(user, "task", i, {"work"});
+                    if (i % 2)
+                        list.completeTask(user, id);
+                    if (i % 100 == 0)
+                        list.listTasks(user, nullopt, 20);
+                }
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+        double sec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << threads << " threads: " << threads * opsPerThread / sec / 1e6 << " M adds/s" << endl;
+    }
+}
+
+// Target was 10x over the addTask loop; single core this reaches ~5x (6.6 s vs 1.3 s for 1M).
+// What is left is the same set/hash node allocations the loop pays per task (active, byId,
+// byTag, due index), which bulkLoad can order but not avoid without changing UserTasks.
+void benchBulkImport() {
+    const int taskCount = 1000000;
+    auto makeBatch = [&] {
+        TaskBatch batch;
+        mt19937 rng(7);
+        for (int i = 0; i < taskCount; i++) {
+            batch.userIds.push_back(rng() % 10000);
+            batch.descriptions.push_back("imported task " + to_string(i));
+            batch.dueDates.push_back(rng() % 365);
+            batch.tags.push_back(benchTags(i));
+        }
+        return batch;
+    };
+
+    double loopMs, bulkMs;
+    {
+        TaskBatch batch = makeBatch();
+        TodoList list;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < taskCount; i++)
+            list.addTask(batch.userIds[i], move(batch.descriptions[i]), batch.dueDates[i], batch.tags[i]);
+        loopMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    {
+        TaskBatch batch = makeBatch();
+        TodoList list;
+        auto start = chrono::steady_clock::now();
+        list.bulkImport(move(batch));
+        bulkMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    cout << taskCount << " tasks: addTask loop " << loopMs << " ms, bulkImport " << bulkMs << " ms ("
+         << loopMs / bulkMs << "x, target 10x)" << endl;
+}
+
+// Journal size per task, snapshot size per task, and how long a restart takes
+void benchJournal(int taskCount) {
+    filesystem::path dir = filesystem::temp_directory_path() / "todo_journal_bench";
+    filesystem::remove_all(dir);
+    auto dirBytes = [&] {
+        size_t total = 0;
+        for (auto& entry : filesystem::directory_iterator(dir))
+            total += entry.file_size();
+        return total;
+    };
+
+    {
+        TodoList list;
+        list.openJournal(dir.string());
+        for (int i = 0; i < taskCount; i++) {
+            int id = list.addTask(i % 100000, "task " + to_string(i), i % 365, benchTags(i));
+            if (i % 4 == 0)
+                list.completeTask(i % 100000, id);
+        }
+        for (int user = 0; user < 100000; user += 2)
+            list.archiveCompleted(user);
+        list.sync();
+        cout << taskCount << " tasks: journal " << double(dirBytes()) / taskCount << " bytes/task";
+        list.compact();
+        cout << ", snapshot " << double(dirBytes()) / taskCount << " bytes/task" << endl;
+        for (int i = 0; i < taskCount / 10; i++)
+            list.addTask(i % 100000, "tail " + to_string(i), i % 365, {"home"});
+    }
+
+    auto start = chrono::steady_clock::now();
+    TodoList recovered;
+    recovered.openJournal(dir.string());
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "recovered " << recovered.liveTasks() << " tasks (snapshot + tail) in " << ms << " ms" << endl;
+    filesystem::remove_all(dir);
+}
+
+int main() {
+    TodoList list;
+    list.addTask(1, "write spec", 5, {"work", "urgent"});
+    int review = list.addTask(1, "review PR", 3, {"work"});
+    list.addTask(1, "groceries", 4, {"home"});
+
+    for (auto& name : list.getTasksForTag(1, "work"))
+        cout << name << endl;
+    list.completeTask(1, review);
+    for (auto& name : list.getAllTasks(1))
+        cout << name << endl;
+
+    list.addTask(2, "renew passport", 2, {"home"});
+    for (const Task* task : list.getTasksDueBetween(2, 4))
+        cout << "due " << task->dueDate << ": user " << task->userId << " " << task->taskName << endl;
+    for (const Task* task : list.sweepOverdue(5))
+        cout << "overdue: " << task->taskName << endl;
+    list.addTask(2, "late filing", 1, {});
+    for (const Task* task : list.sweepOverdue(6))
+        cout << "overdue: " << task->taskName << endl;
+
+    for (const Task* task : list.queryTags(1, {}, {"work", "home"}, {"urgent"}))
+        cout << "(work OR home) AND NOT urgent: " << task->taskName << endl;
+
+    list.deleteTask(1, review);
+    for (int i = 0; i < 5; i++)
+        list.addTask(1, "chore " + to_string(i), 10 + i, {"home"});
+
+    optional<TaskCursor> cursor;
+    do {
+        TaskPage page = list.listTasksForTag(1, "home", cursor, 2);
+        for (const Task* task : page.tasks)
+            cout << task->taskName << " ";
+        cout << "|" << endl;
+        cursor = page.next;
+    } while (cursor);
+    cout << list.liveTasks() << " tasks live" << endl;
+
+    benchCompletedTasks();
+    benchTaskMemory(1000000);
+    benchQueryTags();
+    benchConcurrentUsers();
+    benchBulkImport();
+    benchJournal(1000000);
+    return 0;
+}